@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "huff_adaptive.h"
+
+// ==========================================
+// 1. 建樹 / 更新 (FGK)
+// ==========================================
+
+void adaptive_init(AdaptiveTree* t) {
+    // 一開始只有根，根本身就是 NYT
+    int root = ADAPT_NODES - 1;
+    for (int s = 0; s < ADAPT_SYMBOLS; s++) t->leaf[s] = -1;
+    memset(t->nodes, 0, sizeof(t->nodes));
+    t->nodes[root].parent = -1;
+    t->nodes[root].left = t->nodes[root].right = -1;
+    t->nodes[root].symbol = -1;
+    t->nyt = root;
+}
+
+// 交換兩個編號上的子樹：內容互換、parent 留在原位，再修正小孩和葉子的指標
+static void swap_nodes(AdaptiveTree* t, int a, int b) {
+    AdaptiveNode* na = &t->nodes[a];
+    AdaptiveNode* nb = &t->nodes[b];
+    AdaptiveNode tmp = *na;
+    na->weight = nb->weight; na->left = nb->left; na->right = nb->right; na->symbol = nb->symbol;
+    nb->weight = tmp.weight; nb->left = tmp.left; nb->right = tmp.right; nb->symbol = tmp.symbol;
+
+    int pos[2] = { a, b };
+    for (int k = 0; k < 2; k++) {
+        AdaptiveNode* n = &t->nodes[pos[k]];
+        if (n->left < 0) {
+            if (n->symbol >= 0) t->leaf[n->symbol] = pos[k];
+            else t->nyt = pos[k];
+        }
+        else {
+            t->nodes[n->left].parent = pos[k];
+            t->nodes[n->right].parent = pos[k];
+        }
+    }
+}
+
+// 新符號：NYT 分裂成內部節點，左邊是新的 NYT，右邊是新符號的葉子
+static int split_nyt(AdaptiveTree* t, int sym) {
+    int old = t->nyt;
+    int zero = old - 2, leaf = old - 1;
+    AdaptiveNode* o = &t->nodes[old];
+    o->left = zero;
+    o->right = leaf;
+
+    t->nodes[leaf].weight = 0;
+    t->nodes[leaf].parent = old;
+    t->nodes[leaf].left = t->nodes[leaf].right = -1;
+    t->nodes[leaf].symbol = sym;
+
+    t->nodes[zero].weight = 0;
+    t->nodes[zero].parent = old;
+    t->nodes[zero].left = t->nodes[zero].right = -1;
+    t->nodes[zero].symbol = -1;
+
+    t->leaf[sym] = leaf;
+    t->nyt = zero;
+    return leaf;
+}
+
+static void update(AdaptiveTree* t, int sym) {
+    int q = t->leaf[sym];
+    if (q < 0) q = split_nyt(t, sym);
+
+    // 從葉子往上：先跟同 weight 裡編號最大的節點交換 (不能是自己的 parent)，再加一
+    while (q >= 0) {
+        uint64_t w = t->nodes[q].weight;
+        int leader = q;
+        while (leader + 1 < ADAPT_NODES && t->nodes[leader + 1].weight == w) leader++;
+        if (leader != q && leader != t->nodes[q].parent) {
+            swap_nodes(t, q, leader);
+            q = leader;
+        }
+        t->nodes[q].weight++;
+        q = t->nodes[q].parent;
+    }
+}
+
+// ==========================================
+// 2. 編碼 / 解碼一個符號
+// ==========================================
+
+// 從節點往根走，得到的 bit 是反的；存起來再從根那端開始輸出
+static void put_path(const AdaptiveTree* t, BitWriter* bw, int node) {
+    uint8_t bits[ADAPT_NODES];
+    int depth = 0;
+    while (t->nodes[node].parent >= 0) {
+        int p = t->nodes[node].parent;
+        bits[depth++] = (uint8_t)(t->nodes[p].right == node);
+        node = p;
+    }
+    // 一次最多湊 24 bit 再交給 bw_put
+    while (depth > 0) {
+        int take = depth < 24 ? depth : 24;
+        uint32_t code = 0;
+        for (int i = 0; i < take; i++) code = (code << 1) | bits[--depth];
+        bw_put(bw, code, take);
+    }
+}
+
+void adaptive_encode(AdaptiveTree* t, BitWriter* bw, int sym) {
+    if (t->leaf[sym] >= 0) {
+        put_path(t, bw, t->leaf[sym]);
+    }
+    else {
+        put_path(t, bw, t->nyt);
+        bw_put(bw, (uint32_t)sym, ADAPT_LIT_BITS);
+    }
+    update(t, sym);
+}
+
+void adaptive_sync(AdaptiveTree* t, BitWriter* bw) {
+    put_path(t, bw, t->nyt);
+    bw_put(bw, ADAPT_FLUSH, ADAPT_LIT_BITS);
+    bw_align(bw);
+}
+
+int adaptive_decode(AdaptiveTree* t, BitReader* br) {
+    int node = ADAPT_NODES - 1;
+    uint32_t bit;
+    while (t->nodes[node].left >= 0) {
+        if (br_read_bits(br, 1, &bit) != 0) return -1;
+        node = bit ? t->nodes[node].right : t->nodes[node].left;
+    }
+    int sym = t->nodes[node].symbol;
+    if (node == t->nyt) {
+        uint32_t v;
+        if (br_read_bits(br, ADAPT_LIT_BITS, &v) != 0 || v > ADAPT_FLUSH) return -1;
+        sym = (int)v;
+        if (sym < ADAPT_EOF && t->leaf[sym] >= 0) return -1; // 出現過的符號不會再走 NYT
+    }
+    if (sym < ADAPT_EOF) update(t, sym);
+    return sym;
+}
+
+// ==========================================
+// 3. 整個檔案
+// ==========================================
+
+// 用 read 而不是 fread：pipe 有多少就先拿多少，不用等緩衝區填滿
+static long read_some(FILE* fin, unsigned char* buf, size_t cap) {
+#ifdef _WIN32
+    return (long)_read(_fileno(fin), buf, (unsigned)cap);
+#else
+    return (long)read(fileno(fin), buf, cap);
+#endif
+}
+
+int adaptive_compress(FILE* fin, FILE* fout) {
+    AdaptiveTree* t = (AdaptiveTree*)malloc(sizeof(AdaptiveTree));
+    unsigned char* in = (unsigned char*)malloc(HUFF_IO_BUF);
+    BitWriter bw;
+    if (!t || !in || bw_init(&bw, fout) != 0) {
+        free(t);
+        free(in);
+        return -1;
+    }
+    adaptive_init(t);
+
+    // 沒有檔頭要等：magic 寫完就可以開始輸出
+    if (fwrite(HUFA_MAGIC, 1, 4, fout) != 4) {
+        free(t);
+        free(in);
+        bw_finish(&bw);
+        return -1;
+    }
+    long n;
+    while ((n = read_some(fin, in, HUFF_IO_BUF)) > 0) {
+        for (long i = 0; i < n; i++) adaptive_encode(t, &bw, in[i]);
+        // 沒拿滿代表上游暫時沒資料：補同步標記，連最後一個符號的尾巴都送出去，下游馬上解得出來
+        if (n < HUFF_IO_BUF) adaptive_sync(t, &bw);
+        bw_flush_buf(&bw);
+        fflush(fout);
+    }
+    adaptive_encode(t, &bw, ADAPT_EOF);
+    bw_finish(&bw);
+    free(t);
+    free(in);
+    return n < 0 ? -1 : 0;
+}
+
+uint64_t adaptive_decompress(FILE* fin, FILE* fout, int* ok) {
+    AdaptiveTree* t = (AdaptiveTree*)malloc(sizeof(AdaptiveTree));
+    unsigned char* in = (unsigned char*)malloc(HUFF_IO_BUF);
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUF);
+    uint64_t written = 0;
+    *ok = 0;
+    if (!t || !in || !out) {
+        free(t);
+        free(in);
+        free(out);
+        return 0;
+    }
+    adaptive_init(t);
+
+    // 讀記憶體的 BitReader 只看 in[0, have)；一個碼解到一半資料不夠時，
+    // 退回這個碼開始的位置，讀到更多再重解 (樹只在解完整個碼後才更新，不用還原)
+    BitReader br;
+    size_t have = 0;
+    int eof = 0;
+    size_t len = 0;
+    br_init_mem(&br, NULL, 0);   // 還沒有資料，第一次解碼就會去讀
+    for (;;) {
+        BitReader save = br;
+        int sym = adaptive_decode(t, &br);
+        if (sym == ADAPT_EOF) {
+            *ok = 1;
+            break;
+        }
+        if (sym == ADAPT_FLUSH) {
+            // 同步標記後面補到 byte 邊界 (acc 只會整個 byte 載入，真的 bit 數除 8 的餘數就是要丟的)
+            uint32_t skip;
+            br_read_bits(&br, (br.bitcnt - (int)br.pad * 8) & 7, &skip);
+            continue;
+        }
+        if (sym >= 0) {
+            out[len++] = (unsigned char)sym;
+            if (len == HUFF_IO_BUF) {
+                fwrite(out, 1, len, fout);
+                written += len;
+                len = 0;
+            }
+            continue;
+        }
+        // 解不出來：讀到結尾或是資料壞掉就結束，否則只是這段還不夠一個碼
+        if (eof || !(br.pad && br_overrun(&br))) break;
+
+        // 接下來的 read 可能要等上游：先把解好的送出去
+        if (len) fwrite(out, 1, len, fout);
+        written += len;
+        len = 0;
+        fflush(fout);
+
+        // 還沒用到的 byte 搬到前面，後面接新讀到的資料，再跳過 save 那時已經讀掉的幾個 bit
+        uint64_t bitpos = (uint64_t)save.pos * 8 - (uint64_t)(save.bitcnt - (int)save.pad * 8);
+        size_t start = (size_t)(bitpos >> 3);
+        size_t rest = have - start;
+        memmove(in, in + start, rest);
+        long n = read_some(fin, in + rest, HUFF_IO_BUF - rest);
+        if (n < 0) break;
+        if (n == 0) eof = 1;
+        have = rest + (size_t)n;
+        br_init_mem(&br, in, have);
+        uint32_t skip;
+        br_read_bits(&br, (int)(bitpos & 7), &skip);
+    }
+    fwrite(out, 1, len, fout);
+    written += len;
+    free(t);
+    free(in);
+    free(out);
+    return written;
+}
@@ -0,0 +1,65 @@
+// huff_adaptive.h - 一次掃描的動態 Huffman (FGK)
+//
+// 檔案 = "HUFA" + bitstream，沒有頻率表也沒有原始大小
+// 編碼端和解碼端從同一棵只有 NYT 的樹開始，每處理一個符號就用同樣的規則更新樹
+//   出現過的符號：輸出它目前的碼
+//   第一次出現   ：輸出 NYT 的碼 + 9 bit 的符號值
+//   結束         ：輸出 NYT 的碼 + 9 bit 的 ADAPT_EOF
+//   輸入暫停     ：輸出 NYT 的碼 + 9 bit 的 ADAPT_FLUSH，再補 0 到整個 byte，手上的 bit 全部送出去
+#ifndef HUFF_ADAPTIVE_H
+#define HUFF_ADAPTIVE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_core.h"
+
+#define HUFA_MAGIC     "HUFA"
+#define ADAPT_SYMBOLS  257                     // 256 個 byte + 結束符號
+#define ADAPT_EOF      256
+#define ADAPT_FLUSH    257                     // 不在樹裡，只當同步標記
+#define ADAPT_NODES    (2 * ADAPT_SYMBOLS + 1) // 每個符號一片葉子 + NYT + 內部節點
+#define ADAPT_LIT_BITS 9
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+// 節點直接放在陣列裡，陣列索引就是 FGK 的節點編號 (越大越靠近根)
+// sibling property：照編號排列時 weight 不會變小，而且兄弟節點編號相鄰
+typedef struct {
+    uint64_t weight;
+    int parent;
+    int left, right;   // -1 = 葉子
+    int symbol;        // 內部節點是 -1
+} AdaptiveNode;
+
+typedef struct {
+    AdaptiveNode nodes[ADAPT_NODES];
+    int leaf[ADAPT_SYMBOLS];   // 符號 → 葉子編號，還沒出現過是 -1
+    int nyt;                   // NYT 葉子的編號
+} AdaptiveTree;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+void adaptive_init(AdaptiveTree* t);
+
+/* 輸出 sym 目前的碼 (新符號先輸出 NYT 再輸出 9 bit 原值)，然後更新樹 */
+void adaptive_encode(AdaptiveTree* t, BitWriter* bw, int sym);
+
+/* 輸出同步標記並補齊到 byte 邊界，之前編的符號解碼端都能完整解出 */
+void adaptive_sync(AdaptiveTree* t, BitWriter* bw);
+
+/* 沿著樹讀 bit 解出一個符號並更新樹 (ADAPT_FLUSH 不更新)；資料截斷或壞掉回傳 -1 */
+int  adaptive_decode(AdaptiveTree* t, BitReader* br);
+
+/* 從 fin 讀到檔尾，邊讀邊編碼；read 沒拿滿 (輸入暫停) 就加同步標記，把編好的全部送出去
+   回傳 0 成功 */
+int  adaptive_compress(FILE* fin, FILE* fout);
+
+/* magic 已經用 read 讀掉 (fin 的 stdio 緩衝區必須是空的)，從 fin 解到結束符號
+   用 read 拿資料，每次要等輸入前先把解好的寫出去；回傳解出的 byte 數，資料壞掉時 *ok = 0 */
+uint64_t adaptive_decompress(FILE* fin, FILE* fout, int* ok);
+
+#endif // HUFF_ADAPTIVE_H
@@ -0,0 +1,235 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "huff_ans.h"
+
+// ==========================================
+// 1. 正規化
+// ==========================================
+
+// 把次數縮放成總和 2^table_log：先照比例取整數 (出現過的至少 1)，
+// 差額一次調一格，每次挑讓總 bit 數變化最小的符號
+static void normalize(const int freq[MAX_SYMBOLS], size_t n, int table_log, int norm[MAX_SYMBOLS]) {
+    int total = 1 << table_log;
+    int sum = 0;
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        norm[s] = 0;
+        if (freq[s] == 0) continue;
+        norm[s] = (int)((uint64_t)freq[s] * (uint64_t)total / n);
+        if (norm[s] == 0) norm[s] = 1;
+        sum += norm[s];
+    }
+    while (sum < total) {
+        int best = -1;
+        double gain = 0.0;
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            if (norm[s] == 0) continue;
+            double g = freq[s] * log2((double)(norm[s] + 1) / norm[s]);
+            if (best < 0 || g > gain) {
+                best = s;
+                gain = g;
+            }
+        }
+        norm[best]++;
+        sum++;
+    }
+    while (sum > total) {
+        int best = -1;
+        double loss = 0.0;
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            if (norm[s] <= 1) continue;
+            double l = freq[s] * log2((double)norm[s] / (norm[s] - 1));
+            if (best < 0 || l < loss) {
+                best = s;
+                loss = l;
+            }
+        }
+        norm[best]--;
+        sum--;
+    }
+}
+
+// 最高位是第幾位 (x > 0)
+static int high_bit(uint32_t x) {
+    int b = 0;
+    while (x >>= 1) b++;
+    return b;
+}
+
+// FSE 的撒法：以固定步長繞狀態表一圈，同一個符號的狀態會分散開
+static void spread_symbols(const int norm[MAX_SYMBOLS], int table_log, uint8_t* symbol_at) {
+    uint32_t size = 1u << table_log;
+    uint32_t step = (size >> 1) + (size >> 3) + 3;
+    uint32_t pos = 0;
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        for (int k = 0; k < norm[s]; k++) {
+            symbol_at[pos] = (uint8_t)s;
+            pos = (pos + step) & (size - 1);
+        }
+    }
+}
+
+// ==========================================
+// 2. 次數表讀寫
+// ==========================================
+
+static size_t put_norm_table(const AnsModel* m, unsigned char* out) {
+    int count = MAX_SYMBOLS;
+    while (count > 0 && m->norm[count - 1] == 0) count--;
+    size_t p = 0;
+    out[p++] = (unsigned char)m->table_log;
+    p += put_varint(out + p, (uint64_t)count);
+    for (int s = 0; s < count;) {
+        p += put_varint(out + p, (uint64_t)m->norm[s]);
+        if (m->norm[s++] != 0) continue;
+        int zeros = 0;
+        while (s < count && m->norm[s] == 0 && zeros < 255) {
+            zeros++;
+            s++;
+        }
+        out[p++] = (unsigned char)zeros;
+    }
+    return p;
+}
+
+// 回傳用掉的 byte 數；格式不對或總和不是 2^table_log 回傳 -1
+static int get_norm_table(const unsigned char* in, size_t avail, int* table_log, int norm[MAX_SYMBOLS]) {
+    if (avail < 1) return -1;
+    *table_log = in[0];
+    if (*table_log < ANS_MIN_TABLE_LOG || *table_log > ANS_MAX_TABLE_LOG) return -1;
+    uint64_t count, v;
+    size_t p = 1;
+    int k = get_varint(in + p, avail - p, &count);
+    if (k < 0 || count == 0 || count > MAX_SYMBOLS) return -1;
+    p += (size_t)k;
+    memset(norm, 0, sizeof(int) * MAX_SYMBOLS);
+    uint32_t total = 1u << *table_log;
+    uint32_t sum = 0;
+    for (int s = 0; s < (int)count;) {
+        k = get_varint(in + p, avail - p, &v);
+        if (k < 0 || v > total - sum) return -1;
+        p += (size_t)k;
+        norm[s++] = (int)v;
+        sum += (uint32_t)v;
+        if (v != 0) continue;
+        if (p >= avail || s + in[p] > (int)count) return -1;
+        s += in[p++];
+    }
+    return sum == total ? (int)p : -1;
+}
+
+// ==========================================
+// 3. 編碼
+// ==========================================
+
+void ans_build(const int freq[MAX_SYMBOLS], size_t n, AnsModel* m) {
+    m->table_log = ANS_TABLE_LOG;
+    normalize(freq, n, m->table_log, m->norm);
+    // 每個符號大約花 log2(2^table_log / norm) bit，再加開頭的狀態
+    double bits = m->table_log;
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        if (freq[s]) bits += freq[s] * (m->table_log - log2((double)m->norm[s]));
+    }
+    unsigned char table[2 + VARINT_MAX + 2 * MAX_SYMBOLS];
+    m->bits = (uint64_t)ceil(bits);
+    m->size = put_norm_table(m, table) + (size_t)((m->bits + 7) / 8);
+}
+
+size_t ans_encode(const unsigned char* in, size_t n, const AnsModel* m, unsigned char* out) {
+    int table_log = m->table_log;
+    uint32_t size = 1u << table_log;
+    uint8_t symbol_at[1 << ANS_MAX_TABLE_LOG];
+    uint16_t state_table[1 << ANS_MAX_TABLE_LOG];
+    uint32_t delta_bits[MAX_SYMBOLS];
+    int32_t delta_state[MAX_SYMBOLS];
+
+    // 每個符號的狀態依在表裡出現的順序排在 cumul[s] 開始的那一段
+    int cumul[MAX_SYMBOLS + 1];
+    cumul[0] = 0;
+    for (int s = 0; s < MAX_SYMBOLS; s++) cumul[s + 1] = cumul[s] + m->norm[s];
+    spread_symbols(m->norm, table_log, symbol_at);
+    int next[MAX_SYMBOLS];
+    memcpy(next, cumul, sizeof(next));
+    for (uint32_t u = 0; u < size; u++) state_table[next[symbol_at[u]]++] = (uint16_t)(size + u);
+
+    // 狀態 x 編 s 要吐幾個 bit：x >= min_state 時 max_bits 個，否則少 1 個 (同 FSE 的算法)
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        int c = m->norm[s];
+        if (c == 0) continue;
+        int max_bits = (c == 1) ? table_log : table_log - high_bit((uint32_t)c - 1);
+        uint32_t min_state = (uint32_t)c << max_bits;
+        delta_bits[s] = ((uint32_t)max_bits << 16) - min_state;
+        delta_state[s] = cumul[s] - c;
+    }
+
+    // 從最後一個符號往前編；每個符號吐出的 bit 先記下來 (值 << 4 | bit 數)，最後再照順序寫出
+    uint16_t* chunk = (uint16_t*)malloc(n * sizeof(uint16_t));
+    if (!chunk) return 0;
+    uint32_t x = size;
+    for (size_t i = n; i-- > 0;) {
+        unsigned s = in[i];
+        uint32_t nb = (x + delta_bits[s]) >> 16;
+        chunk[i] = (uint16_t)(((x & ((1u << nb) - 1)) << 4) | nb);
+        x = state_table[(int32_t)(x >> nb) + delta_state[s]];
+    }
+
+    size_t head = put_norm_table(m, out);
+    BitWriter bw;
+    bw_init_mem(&bw, out + head);
+    bw_put(&bw, x - size, table_log);
+    for (size_t i = 0; i < n; i++) bw_put(&bw, chunk[i] >> 4, chunk[i] & 15);
+    bw_finish(&bw);
+    free(chunk);
+    return head + (size_t)bw.total;
+}
+
+// ==========================================
+// 4. 解碼
+// ==========================================
+
+int ans_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n, size_t* table_bytes) {
+    int table_log;
+    int norm[MAX_SYMBOLS];
+    int used = get_norm_table(in, len, &table_log, norm);
+    if (used < 0) return -1;
+
+    uint32_t size = 1u << table_log;
+    uint8_t symbol_at[1 << ANS_MAX_TABLE_LOG];
+    AnsDecodeEntry table[1 << ANS_MAX_TABLE_LOG];
+    spread_symbols(norm, table_log, symbol_at);
+    int next[MAX_SYMBOLS];
+    memcpy(next, norm, sizeof(next));
+    for (uint32_t u = 0; u < size; u++) {
+        int s = symbol_at[u];
+        uint32_t x = (uint32_t)next[s]++;
+        int nb = table_log - high_bit(x);
+        table[u].symbol = (uint8_t)s;
+        table[u].bits = (uint8_t)nb;
+        table[u].next = (uint16_t)((x << nb) - size);
+    }
+    if (table_bytes) *table_bytes = size * sizeof(AnsDecodeEntry);
+
+    BitReader br;
+    br_init_mem(&br, in + used, len - (size_t)used);
+    br_refill(&br);
+    uint32_t state = (uint32_t)(br.acc >> (64 - table_log));
+    br.acc <<= table_log;
+    br.bitcnt -= table_log;
+
+    // 每次補滿 acc 後連續解 per_refill 個；bit 數是 0 時 (acc >> 63 >> 1) 剛好是 0
+    int per_refill = 56 / table_log;
+    size_t done = 0;
+    while (done < n) {
+        br_refill(&br);
+        for (int k = 0; k < per_refill && done < n; k++) {
+            AnsDecodeEntry e = table[state];
+            out[done++] = e.symbol;
+            state = e.next + (uint32_t)((br.acc >> (63 - e.bits)) >> 1);
+            br.acc <<= e.bits;
+            br.bitcnt -= e.bits;
+        }
+        if (br.pad && br_overrun(&br)) return -1;
+    }
+    // 編碼端從狀態 2^table_log 開始，解完應該剛好回到 0
+    return state == 0 ? 0 : -1;
+}
@@ -0,0 +1,53 @@
+// huff_ans.h - tANS (FSE) 熵編碼：跟 Huffman 二選一 (-e huff|ans)
+//
+// Huffman 的碼長都是整數 bit，p = 0.9 的符號也要 1 bit；tANS 用一個狀態機把小數 bit 累積起來
+// 直方圖先正規化成總和 2^table_log (出現過的符號至少 1)，照 FSE 的方式把符號撒進狀態表
+// 編碼從最後一個符號往前做，解碼從第一個往後：每步查表得到符號、要讀幾個 bit、下一個狀態的基底
+//
+// BLOCK_ANS 內容 : table_log (1 byte) | 符號數 (varint，最大符號 + 1) | 正規化次數 | bitstream
+//   正規化次數 : 每個符號一個 varint；0 後面多一個 byte 表示再接幾個 0
+//   bitstream  : 最後的狀態 (table_log bit) | 第 0 個符號的 bit | 第 1 個符號的 bit | ...
+#ifndef HUFF_ANS_H
+#define HUFF_ANS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_core.h"
+
+#define ANS_TABLE_LOG     12
+#define ANS_MIN_TABLE_LOG 8    // 至少要放得下 256 個符號
+#define ANS_MAX_TABLE_LOG 12
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    int table_log;
+    int norm[MAX_SYMBOLS];    // 正規化後的次數，總和 2^table_log
+    uint64_t bits;            // 估計的 bitstream bit 數
+    size_t size;              // 估計的 block 內容 byte 數
+} AnsModel;
+
+// 解碼表的一格
+typedef struct {
+    uint16_t next;     // 下一個狀態 = next + 讀進來的 bits
+    uint8_t  symbol;
+    uint8_t  bits;
+} AnsDecodeEntry;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 由直方圖 (n 個 byte) 正規化出 m->norm，並估計編碼後大小 */
+void   ans_build(const int freq[MAX_SYMBOLS], size_t n, AnsModel* m);
+
+/* 依 m 把 in 編成 BLOCK_ANS 的內容，回傳 byte 數；配置失敗回傳 0 */
+size_t ans_encode(const unsigned char* in, size_t n, const AnsModel* m, unsigned char* out);
+
+/* 解 BLOCK_ANS 的內容 (len byte) 成 n 個 byte；資料壞掉回傳 -1
+   table_bytes 不是 NULL 時填入解碼表的大小 (給 --stats) */
+int    ans_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n, size_t* table_bytes);
+
+#endif // HUFF_ANS_H
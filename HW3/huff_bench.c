@@ -0,0 +1,423 @@
+// huff_bench.c - 三種實作 (huffman / huffman_two_mode / main) 在固定語料上的速度和壓縮率比較
+// 用 make bench 編好再到 build/ 裡跑；自己跑的話 huffman、huffman_two_mode、main 要在目前目錄 (或用 -x 指定)
+//
+// 用法：huff_bench [-g] [-d 語料目錄] [-n 大檔 KiB] [-r 重複次數] [-x 名稱=指令]...
+//   語料用固定亂數種子產生，每次都一樣：text / binary / random / skewed / same / deep / 幾個小檔
+//   -g 只產生語料就結束 (給 tests/roundtrip.sh 用)
+//   每個變體對每個檔各壓縮、解壓 r 次取最快的一次，並檢查解回來跟原檔一樣
+//   外部程式的時間包含啟動程式本身，小檔看 ratio 就好；lib 是行程內呼叫 huff_lib，只算編解碼
+//   給了 -x 就只跑 -x 列的變體 (lib 除外)，指令後面會接 -c/-d -i 檔名 -o 檔名
+// 結果以 CSV 印到 stdout：
+//   variant,file,bytes,comp_bytes,ratio,overhead_bytes,comp_mbps,decomp_mbps,ok
+//   有任何一列 ok = 0 (壓縮失敗或解回來不一樣) 時結束碼是 1
+//   overhead_bytes = comp_bytes - 整個檔用一張最佳 Huffman 碼的 bitstream 大小
+//                    也就是檔頭、碼表、block 頭和補齊的 bit；分 block 或動態模式可能是負的
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#define NULL_DEV "NUL"
+#else
+#include <time.h>
+#include <sys/stat.h>
+#define NULL_DEV "/dev/null"
+#endif
+#include "huff_core.h"
+#include "huff_lib.h"
+
+#define MAX_VARIANTS 32
+#define CMD_MAX      1024
+#define CORPUS_BIG   ((size_t)-1)   // 大小用 -n 給的
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    const char* name;
+    const char* cmd;   // NULL = 行程內的 huff_lib
+} Variant;
+
+typedef struct {
+    const char* name;
+    size_t size;       // CORPUS_BIG = 用 -n 給的大小
+    void (*gen)(unsigned char* p, size_t n, uint64_t* seed);
+} CorpusFile;
+
+// 每加一條快速路徑就在這裡多加一列，回歸比較才會涵蓋到
+static const Variant default_variants[] = {
+    { "huffman",          "./huffman" },
+    { "huffman_two_mode", "./huffman_two_mode" },
+    { "main",             "./main" },
+    { "main-s4",          "./main -s 4" },
+    { "main-t4",          "./main -t 4" },
+    { "main-l12",         "./main -l 12" },
+    { "main-l19",         "./main -l 19" },
+    { "main-a",           "./main -a" },
+    { "main-k1",          "./main -k 1" },
+    { "main-r",           "./main -r" },
+    { "main-z1",          "./main -z 1" },
+    { "main-z6",          "./main -z 6" },
+    { "main-ans",         "./main -e ans" },
+    { "main-f16",         "./main -f 16" },
+};
+
+// ==========================================
+// 1. 計時
+// ==========================================
+
+static double now_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// ==========================================
+// 2. 產生語料 (固定種子的 xorshift，跨平台結果一樣)
+// ==========================================
+
+static uint32_t next_rand(uint64_t* s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return (uint32_t)(*s >> 32);
+}
+
+// 英文單字照 Zipf 分布挑，偶爾斷行
+static void gen_text(unsigned char* p, size_t n, uint64_t* seed) {
+    static const char* words[] = {
+        "the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "was", "with",
+        "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which",
+        "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+        "huffman", "code", "length", "table", "block", "stream", "decoder", "symbol",
+        "frequency", "compression", "performance", "benchmark", "regression", "throughput",
+    };
+    const int nw = (int)(sizeof(words) / sizeof(words[0]));
+    size_t i = 0;
+    while (i < n) {
+        // 1/r 分布：取 [1, nw] 的倒數近似
+        int r = (int)(nw / (1.0 + (next_rand(seed) % 1000) * (nw - 1) / 1000.0)) - 1;
+        if (r < 0) r = 0;
+        const char* w = words[r];
+        for (size_t k = 0; w[k] && i < n; k++) p[i++] = (unsigned char)w[k];
+        if (i < n) p[i++] = (next_rand(seed) % 12 == 0) ? '\n' : ' ';
+    }
+}
+
+// 像執行檔或資料庫頁面：遞增的 little-endian 整數、小數值、0 填充交錯
+static void gen_binary(unsigned char* p, size_t n, uint64_t* seed) {
+    uint32_t counter = 0x1000;
+    size_t i = 0;
+    while (i < n) {
+        uint32_t kind = next_rand(seed) % 4;
+        uint32_t v = kind == 0 ? counter++ : kind == 1 ? next_rand(seed) % 256 : kind == 2 ? 0 : next_rand(seed);
+        for (int k = 0; k < 4 && i < n; k++) p[i++] = (unsigned char)(v >> (8 * k));
+    }
+}
+
+static void gen_random(unsigned char* p, size_t n, uint64_t* seed) {
+    for (size_t i = 0; i < n; i++) p[i] = (unsigned char)next_rand(seed);
+}
+
+// 幾何分布：少數幾個 byte 佔大部分，碼長會拉很長
+static void gen_skewed(unsigned char* p, size_t n, uint64_t* seed) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t r = next_rand(seed);
+        int s = 0;
+        while ((r & 1) && s < 255) {
+            r >>= 1;
+            s++;
+            if (r == 0) r = next_rand(seed);
+        }
+        p[i] = (unsigned char)s;
+    }
+}
+
+static void gen_same(unsigned char* p, size_t n, uint64_t* seed) {
+    (void)seed;
+    memset(p, 'A', n);
+}
+
+// 碼長拉到 19 以上：DEEP_COMMON 個常見 byte 平分大部分機率，
+// 接著一串機率每次減半的 byte，剩下的 byte 各只出現一次 (n 要 512 KiB 以上才夠深)
+#define DEEP_COMMON 100
+#define DEEP_CHAIN  11
+
+static void gen_deep(unsigned char* p, size_t n, uint64_t* seed) {
+    const uint32_t common_w = 2u << DEEP_CHAIN;
+    const uint32_t total = DEEP_COMMON * common_w + (2u << DEEP_CHAIN) - 2;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t r = next_rand(seed) % total;
+        if (r < DEEP_COMMON * common_w) {
+            p[i] = (unsigned char)(r / common_w);
+            continue;
+        }
+        r -= DEEP_COMMON * common_w;
+        int j = 0;
+        while (j < DEEP_CHAIN - 1 && r >= (1u << (DEEP_CHAIN - j))) {
+            r -= 1u << (DEEP_CHAIN - j);
+            j++;
+        }
+        p[i] = (unsigned char)(DEEP_COMMON + j);
+    }
+    int rare = 256 - DEEP_COMMON - DEEP_CHAIN;
+    if (n <= (size_t)rare) return;
+    unsigned char* q = p + next_rand(seed) % (n - rare);
+    for (int k = 0; k < rare; k++) q[k] = (unsigned char)(DEEP_COMMON + DEEP_CHAIN + k);
+}
+
+static const CorpusFile corpus[] = {
+    { "text.txt",    CORPUS_BIG, gen_text },
+    { "binary.bin",  CORPUS_BIG, gen_binary },
+    { "random.bin",  CORPUS_BIG, gen_random },
+    { "skewed.bin",  CORPUS_BIG, gen_skewed },
+    { "same.bin",    CORPUS_BIG, gen_same },
+    { "deep.bin",    CORPUS_BIG, gen_deep },
+    { "tiny0.txt",   0,          gen_text },
+    { "tiny1.txt",   1,          gen_text },
+    { "tiny64.txt",  64,         gen_text },
+    { "tiny500.txt", 500,        gen_text },
+};
+
+static int write_file(const char* path, const unsigned char* p, size_t n) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+    size_t w = n ? fwrite(p, 1, n, f) : 0;
+    return (fclose(f) == 0 && w == n) ? 0 : -1;
+}
+
+static unsigned char* read_file(const char* path, size_t* n) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    size_t cap = 1 << 16, len = 0;
+    unsigned char* p = (unsigned char*)malloc(cap);
+    size_t r;
+    while (p && (r = fread(p + len, 1, cap - len, f)) > 0) {
+        len += r;
+        if (len == cap) {
+            unsigned char* q = (unsigned char*)realloc(p, cap * 2);
+            if (!q) {
+                free(p);
+                p = NULL;
+                break;
+            }
+            p = q;
+            cap *= 2;
+        }
+    }
+    fclose(f);
+    *n = len;
+    return p;
+}
+
+// ==========================================
+// 3. 量測
+// ==========================================
+
+// 整個檔用一張碼時 bitstream 的 byte 數，當作「沒有額外負擔」的基準
+static uint64_t ideal_payload(const unsigned char* p, size_t n) {
+    int freq[MAX_SYMBOLS] = {0};
+    int lengths[MAX_SYMBOLS];
+    count_block_frequency(p, n, freq);
+    build_code_lengths(freq, lengths);
+    uint64_t bits = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) bits += (uint64_t)freq[i] * (uint64_t)lengths[i];
+    return (bits + 7) / 8;
+}
+
+// 跑外部程式一次，回傳秒數；失敗回傳負值
+static double run_cmd(const char* cmd, const char* flag, const char* in, const char* out) {
+    char line[4 * CMD_MAX];
+    snprintf(line, sizeof(line), "%s %s -i \"%s\" -o \"%s\" > %s 2>&1", cmd, flag, in, out, NULL_DEV);
+    double t0 = now_sec();
+    int rc = system(line);
+    double t = now_sec() - t0;
+    return rc == 0 ? t : -1.0;
+}
+
+// 行程內用 huff_lib 壓縮 / 解壓一次，結果留在 buffer 裡
+static double run_lib(HuffCtx* ctx, int compress, const unsigned char* src, size_t n,
+                      unsigned char* dst, size_t cap, size_t* out_len) {
+    double t0 = now_sec();
+    int rc = compress ? huff_compress_buf(ctx, src, n, dst, cap, out_len)
+                      : huff_decompress_buf(ctx, src, n, dst, cap, out_len);
+    double t = now_sec() - t0;
+    return rc == HUFF_OK ? t : -1.0;
+}
+
+static double mbps(size_t bytes, double sec) {
+    return sec > 0 ? (double)bytes / sec / 1e6 : 0.0;
+}
+
+static int bench_one(const Variant* v, const char* dir, const char* name, int repeat, HuffCtx* ctx) {
+    char in[CMD_MAX], comp[CMD_MAX], back[CMD_MAX];
+    snprintf(in, sizeof(in), "%s/%s", dir, name);
+    snprintf(comp, sizeof(comp), "%s/%s.%s.huf", dir, name, v->name);
+    snprintf(back, sizeof(back), "%s/%s.%s.out", dir, name, v->name);
+
+    size_t n = 0, comp_n = 0, back_n = 0;
+    unsigned char* orig = read_file(in, &n);
+    if (!orig) return 0;
+    unsigned char* cbuf = NULL;
+    unsigned char* rbuf = NULL;
+    double tc = -1.0, td = -1.0;
+    int ok = 1;
+
+    if (!v->cmd) {
+        size_t cap = huff_compress_bound(ctx, n);
+        cbuf = (unsigned char*)malloc(cap);
+        rbuf = (unsigned char*)malloc(n ? n : 1);
+        if (!cbuf || !rbuf) ok = 0;
+        for (int r = 0; ok && r < repeat; r++) {
+            double t = run_lib(ctx, 1, orig, n, cbuf, cap, &comp_n);
+            if (t < 0) ok = 0;
+            else if (tc < 0 || t < tc) tc = t;
+        }
+        for (int r = 0; ok && r < repeat; r++) {
+            double t = run_lib(ctx, 0, cbuf, comp_n, rbuf, n, &back_n);
+            if (t < 0) ok = 0;
+            else if (td < 0 || t < td) td = t;
+        }
+        ok = ok && back_n == n && memcmp(orig, rbuf, n) == 0;
+    }
+    else {
+        for (int r = 0; ok && r < repeat; r++) {
+            double t = run_cmd(v->cmd, "-c", in, comp);
+            if (t < 0) ok = 0;
+            else if (tc < 0 || t < tc) tc = t;
+        }
+        for (int r = 0; ok && r < repeat; r++) {
+            double t = run_cmd(v->cmd, "-d", comp, back);
+            if (t < 0) ok = 0;
+            else if (td < 0 || t < td) td = t;
+        }
+        cbuf = read_file(comp, &comp_n);
+        rbuf = ok ? read_file(back, &back_n) : NULL;
+        ok = ok && cbuf && rbuf && back_n == n && memcmp(orig, rbuf, n) == 0;
+        remove(comp);
+        remove(back);
+    }
+
+    int64_t overhead = (int64_t)comp_n - (int64_t)ideal_payload(orig, n);
+    printf("%s,%s,%zu,%zu,%.4f,%lld,%.2f,%.2f,%d\n", v->name, name, n, comp_n,
+           n ? (double)comp_n / (double)n : 0.0, (long long)overhead,
+           mbps(n, tc), mbps(n, td), ok);
+    fflush(stdout);
+    free(orig);
+    free(cbuf);
+    free(rbuf);
+    return ok;
+}
+
+// ==========================================
+// 4. 主程式
+// ==========================================
+
+int main(int argc, char* argv[]) {
+    const char* dir = "bench_corpus";
+    size_t big = 1024 << 10;
+    int repeat = 3;
+    int gen_only = 0;
+    Variant variants[MAX_VARIANTS];
+    int nv = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "gd:n:r:x:")) != -1) {
+        switch (opt) {
+            case 'g':
+                gen_only = 1;
+                break;
+            case 'd':
+                dir = optarg;
+                break;
+            case 'n':
+                big = (size_t)atol(optarg) << 10;
+                if (big == 0) {
+                    fprintf(stderr, "Error: -n must be > 0 KiB\n");
+                    return 1;
+                }
+                break;
+            case 'r':
+                repeat = atoi(optarg);
+                if (repeat < 1) repeat = 1;
+                break;
+            case 'x': {
+                char* eq = strchr(optarg, '=');
+                if (!eq || eq == optarg || nv >= MAX_VARIANTS - 1) {
+                    fprintf(stderr, "Error: -x expects name=command\n");
+                    return 1;
+                }
+                *eq = '\0';
+                variants[nv].name = optarg;
+                variants[nv].cmd = eq + 1;
+                nv++;
+                break;
+            }
+            default:
+                fprintf(stderr, "Usage: %s [-g] [-d dir] [-n KiB] [-r repeat] [-x name=command]...\n", argv[0]);
+                return 1;
+        }
+    }
+    if (nv == 0) {
+        for (size_t i = 0; i < sizeof(default_variants) / sizeof(default_variants[0]); i++) {
+            variants[nv++] = default_variants[i];
+        }
+    }
+    variants[nv].name = "lib";
+    variants[nv].cmd = NULL;
+    nv++;
+
+    // 產生語料
+#ifdef _WIN32
+    _mkdir(dir);
+#else
+    mkdir(dir, 0755);
+#endif
+    size_t nfiles = sizeof(corpus) / sizeof(corpus[0]);
+    unsigned char* buf = (unsigned char*)malloc(big > 4096 ? big : 4096);
+    if (!buf) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+    for (size_t f = 0; f < nfiles; f++) {
+        char path[CMD_MAX];
+        uint64_t seed = 0x9E3779B97F4A7C15ull + f;
+        size_t n = corpus[f].size == CORPUS_BIG ? big : corpus[f].size;
+        corpus[f].gen(buf, n, &seed);
+        snprintf(path, sizeof(path), "%s/%s", dir, corpus[f].name);
+        if (write_file(path, buf, n) != 0) {
+            fprintf(stderr, "Error: cannot write %s\n", path);
+            free(buf);
+            return 1;
+        }
+    }
+    free(buf);
+    if (gen_only) return 0;
+
+    HuffCtx* ctx = huff_ctx_create(NULL, 0);
+    if (!ctx) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+    printf("variant,file,bytes,comp_bytes,ratio,overhead_bytes,comp_mbps,decomp_mbps,ok\n");
+    int failed = 0;
+    for (int v = 0; v < nv; v++) {
+        fprintf(stderr, "bench %s\n", variants[v].name);
+        for (size_t f = 0; f < nfiles; f++) {
+            if (!bench_one(&variants[v], dir, corpus[f].name, repeat, ctx)) failed = 1;
+        }
+    }
+    huff_ctx_free(ctx);
+    return failed;
+}
@@ -0,0 +1,773 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "huff_block.h"
+#include "huff_order1.h"
+#include "huff_rle.h"
+#include "huff_lz77.h"
+#include "huff_ans.h"
+
+// ==========================================
+// 1. Little-endian 讀寫
+// ==========================================
+
+void put_le32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+void put_le64(unsigned char* p, uint64_t v) {
+    put_le32(p, (uint32_t)v);
+    put_le32(p + 4, (uint32_t)(v >> 32));
+}
+
+uint32_t get_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t get_le64(const unsigned char* p) {
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+// ==========================================
+// 2. 檔頭 / block 頭
+// ==========================================
+
+size_t put_container_header(unsigned char out[HUF2_HEADER_MAX], ContainerHeader* ch) {
+    size_t n = 0;
+    memcpy(out, HUF2_MAGIC, 4);
+    n += 4;
+    out[n++] = ch->version;
+    out[n++] = ch->flags;
+    out[n++] = ch->limit_L;
+    n += put_varint(out + n, ch->block_size >> 10);
+    if (!(ch->flags & HUF2_FLAG_STREAM)) n += put_varint(out + n, ch->original_size);
+    ch->header_size = (uint32_t)n;
+    return n;
+}
+
+// 檢查讀回來的欄位；block_size 是以 KiB 存的
+static int check_container_header(ContainerHeader* ch, uint64_t kib) {
+    if (ch->version != HUF2_VERSION) return -1;
+    if (kib == 0 || kib > (MAX_BLOCK_SIZE >> 10)) return -2;
+    ch->block_size = (uint32_t)kib << 10;
+    if (ch->flags & HUF2_FLAG_STREAM) ch->original_size = HUF2_SIZE_UNKNOWN;
+    return 0;
+}
+
+int get_container_header(const unsigned char* in, size_t avail, ContainerHeader* ch) {
+    uint64_t kib;
+    if (avail < 3) return -3;
+    ch->version = in[0];
+    ch->flags = in[1];
+    ch->limit_L = in[2];
+    size_t n = 3;
+    int k = get_varint(in + n, avail - n, &kib);
+    if (k < 0) return -3;
+    n += (size_t)k;
+    if (!(ch->flags & HUF2_FLAG_STREAM)) {
+        k = get_varint(in + n, avail - n, &ch->original_size);
+        if (k < 0) return -3;
+        n += (size_t)k;
+    }
+    int rc = check_container_header(ch, kib);
+    if (rc != 0) return rc;
+    ch->header_size = (uint32_t)(4 + n);
+    return (int)n;
+}
+
+// 第 1 版的檔頭：version 之後是 flags | limit_L | 保留 | block_size (4) | original_size (8)
+static int read_container_header_v1(FILE* fin, ContainerHeader* ch) {
+    unsigned char rest[HUF2_V1_HEADER_SIZE - 7];
+    if (fread(rest, 1, sizeof(rest), fin) != sizeof(rest)) return -3;
+    ch->block_size = get_le32(rest + 1);
+    ch->original_size = (ch->flags & HUF2_FLAG_STREAM) ? HUF2_SIZE_UNKNOWN : get_le64(rest + 5);
+    if (ch->block_size == 0 || ch->block_size > MAX_BLOCK_SIZE) return -2;
+    ch->header_size = HUF2_V1_HEADER_SIZE;
+    return 0;
+}
+
+int read_container_header(FILE* fin, ContainerHeader* ch) {
+    unsigned char head[3];
+    uint64_t kib;
+    if (fread(head, 1, 3, fin) != 3) return -3;
+    ch->version = head[0];
+    ch->flags = head[1];
+    ch->limit_L = head[2];
+    if (ch->version == HUF2_VERSION_V1) return read_container_header_v1(fin, ch);
+    int k = read_varint(fin, &kib);
+    if (k < 0) return -3;
+    size_t n = 3 + (size_t)k;
+    if (!(ch->flags & HUF2_FLAG_STREAM)) {
+        k = read_varint(fin, &ch->original_size);
+        if (k < 0) return -3;
+        n += (size_t)k;
+    }
+    int rc = check_container_header(ch, kib);
+    if (rc != 0) return rc;
+    ch->header_size = (uint32_t)(4 + n);
+    return 0;
+}
+
+size_t put_block_header(unsigned char out[BLOCK_HEADER_MAX], const BlockHeader* bh) {
+    out[0] = bh->type;
+    if (bh->type == BLOCK_END) return 1;
+    size_t n = 1;
+    n += put_varint(out + n, bh->raw_size);
+    n += put_varint(out + n, bh->comp_size);
+    return n;
+}
+
+// 大小超過 32 bit 的一律當成壞掉
+static int set_block_sizes(BlockHeader* bh, uint64_t raw, uint64_t comp) {
+    if (raw > UINT32_MAX || comp > UINT32_MAX) return -1;
+    bh->raw_size = (uint32_t)raw;
+    bh->comp_size = (uint32_t)comp;
+    return 0;
+}
+
+int get_block_header(const unsigned char* in, size_t avail, BlockHeader* bh) {
+    uint64_t raw, comp;
+    if (avail < 1) return -1;
+    bh->type = in[0];
+    bh->raw_size = bh->comp_size = 0;
+    if (bh->type == BLOCK_END) return 1;
+    int a = get_varint(in + 1, avail - 1, &raw);
+    if (a < 0) return -1;
+    int b = get_varint(in + 1 + a, avail - 1 - (size_t)a, &comp);
+    if (b < 0 || set_block_sizes(bh, raw, comp) != 0) return -1;
+    return 1 + a + b;
+}
+
+int read_block_header(FILE* fin, BlockHeader* bh) {
+    uint64_t raw, comp;
+    int c = fgetc(fin);
+    if (c == EOF) return -1;
+    bh->type = (uint8_t)c;
+    bh->raw_size = bh->comp_size = 0;
+    if (bh->type == BLOCK_END) return 1;
+    int a = read_varint(fin, &raw);
+    int b = (a < 0) ? -1 : read_varint(fin, &comp);
+    if (b < 0 || set_block_sizes(bh, raw, comp) != 0) return -1;
+    return 1 + a + b;
+}
+
+int read_block_header_v1(FILE* fin, BlockHeader* bh) {
+    unsigned char in[BLOCK_V1_HEADER_SIZE];
+    if (fread(in, 1, BLOCK_V1_HEADER_SIZE, fin) != BLOCK_V1_HEADER_SIZE) return -1;
+    bh->type = in[0];
+    bh->raw_size = get_le32(in + 1);
+    bh->comp_size = get_le32(in + 5);
+    return BLOCK_V1_HEADER_SIZE;
+}
+
+// ==========================================
+// 3. Block 編碼 / 解碼
+// ==========================================
+
+size_t block_bound(size_t n) {
+    // 固定 8 bit 的碼也是合法的前綴碼，所以最佳碼 (含長度限制) 平均不會超過 8 bit
+    // bitstream 最多 n byte，再加 bit 寫入器的 word 餘量
+    // 4-stream 時每條各自補到整數 byte，總長還是不超過 n，另外多一個跳躍表
+    return BLOCK_HEADER_MAX + LENGTH_TABLE_MAX + JUMP_TABLE_SIZE + n + 8;
+}
+
+// 內容已經放在 out + BLOCK_HEADER_MAX：補上 block 頭，再把內容往前搬到緊接在頭後面
+static size_t finish_block(unsigned char* out, int type, size_t n, size_t comp_size) {
+    BlockHeader bh;
+    bh.type = (uint8_t)type;
+    bh.raw_size = (uint32_t)n;
+    bh.comp_size = (uint32_t)comp_size;
+    unsigned char hdr[BLOCK_HEADER_MAX];
+    size_t h = put_block_header(hdr, &bh);
+    memmove(out + h, out + BLOCK_HEADER_MAX, comp_size);
+    memcpy(out, hdr, h);
+    return h + comp_size;
+}
+
+// 先做 RLE 再算碼長；編出來比 size0 小才把內容寫進 out 並回傳 byte 數，否則回傳 0
+static size_t rle_block(const unsigned char* in, size_t n, const BlockOptions* opt, size_t size0,
+                        unsigned char* out) {
+    HuffStats* st = opt->stats;
+    double t = st ? stats_now() : 0.0;
+    // RLE 至少要縮掉 1/8 才值得，不到就中途放棄，不會白白掃完整個 block
+    size_t cap = n - n / 8;
+    unsigned char* r = (unsigned char*)malloc(cap + 1);
+    if (!r) return 0;
+    size_t rn = rle_encode(in, n, r, cap);
+    int freq[MAX_SYMBOLS] = {0};
+    int lengths[MAX_SYMBOLS];
+    if (rn > 0) {
+        count_block_frequency(r, rn, freq);
+        build_code_lengths(freq, lengths);
+        int limit_L = opt->limit_L;
+        if (limit_L <= 0 || limit_L > HUFF_MAX_BITS) limit_L = HUFF_MAX_BITS;
+        int max_len = 0;
+        for (int i = 0; i < MAX_SYMBOLS; i++) {
+            if (lengths[i] > max_len) max_len = lengths[i];
+        }
+        if (max_len > limit_L && limit_code_lengths(freq, lengths, limit_L) != 0) rn = 0;
+    }
+    if (st) t = stats_lap(st, STAT_RLE, t);
+
+    size_t comp = 0;
+    if (rn > 0) {
+        uint64_t bits = 0;
+        for (int i = 0; i < MAX_SYMBOLS; i++) bits += (uint64_t)freq[i] * (uint64_t)lengths[i];
+        size_t head = put_varint(out, rn);
+        size_t table_size = put_length_table(lengths, out + head);
+        if (head + table_size + (size_t)((bits + 7) / 8) < size0) {
+            CodeEntry codes[MAX_SYMBOLS];
+            generate_limited_codes(lengths, codes);
+            if (st) t = stats_lap(st, STAT_CODES, t);
+            comp = head + table_size + encode_buffer(r, rn, codes, out + head + table_size);
+            if (st) {
+                stats_lap(st, STAT_ENCODE, t);
+                st->payload_bits += bits;
+                st->table_bytes += table_size;
+            }
+        }
+    }
+    free(r);
+    return comp;
+}
+
+// LZ77 拆序列再編碼；比 size0 小才把內容寫進 out 並回傳 byte 數，否則回傳 0
+static size_t lz_block(const unsigned char* in, size_t n, const BlockOptions* opt, size_t size0,
+                       unsigned char* out) {
+    HuffStats* st = opt->stats;
+    double t = st ? stats_now() : 0.0;
+    LzModel m;
+    if (lz_build(in, n, opt->lz_level, opt->lz_window, opt->limit_L, &m) != 0) return 0;
+    if (st) t = stats_lap(st, STAT_MATCH, t);
+    size_t comp = 0;
+    if (m.size < size0) {
+        comp = lz_encode(in, &m, out);
+        if (st) {
+            stats_lap(st, STAT_ENCODE, t);
+            st->payload_bits += m.bits;
+            st->table_bytes += m.size - (size_t)((m.bits + 7) / 8);
+        }
+    }
+    lz_free(&m);
+    return comp;
+}
+
+static size_t encode_huffman(const unsigned char* in, size_t n, const int lengths[MAX_SYMBOLS], int streams,
+                             size_t cap, unsigned char* out, HuffStats* stats);
+
+// 完整直方圖的最佳碼要花幾個 bit (bitstream + 碼長表)；limit_L 太小回傳 0
+static uint64_t full_cost_bits(const int freq[MAX_SYMBOLS], int limit_L) {
+    int lengths[MAX_SYMBOLS];
+    build_code_lengths(freq, lengths);
+    int max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (lengths[i] > max_len) max_len = lengths[i];
+    }
+    if (max_len > limit_L && limit_code_lengths(freq, lengths, limit_L) != 0) return 0;
+    unsigned char table[LENGTH_TABLE_MAX];
+    uint64_t bits = 8 * (uint64_t)put_length_table(lengths, table);
+    for (int i = 0; i < MAX_SYMBOLS; i++) bits += (uint64_t)freq[i] * (uint64_t)lengths[i];
+    return bits;
+}
+
+// 抽樣碼表編出來的 block 實際花的 bit 數跟完整直方圖比，差多少記到 stats
+static void record_sample_loss(HuffStats* st, const int full[MAX_SYMBOLS], int limit_L, uint64_t cost) {
+    uint64_t best = full_cost_bits(full, limit_L);
+    st->sampled_blocks++;
+    if (best) st->sample_loss_bits += (int64_t)cost - (int64_t)best;
+}
+
+// 樣本沒看到的 byte 還是要有碼，所以每個 byte 都加 1 當保底
+// 看到的符號很少時 (DNA 的 4 種、只有 2 種 byte) 碼長本來就填滿了 Kraft，保底會把其中一個短碼拉長
+// 比較加保底前後樣本本身要花的 bit：多超過 SAMPLE_MAX_FALLBACK_PCT 就回傳 0 (呼叫端改成全部數)
+static int add_sample_fallback(int freq[MAX_SYMBOLS]) {
+    int plain[MAX_SYMBOLS], padded[MAX_SYMBOLS], fb[MAX_SYMBOLS];
+    for (int i = 0; i < MAX_SYMBOLS; i++) fb[i] = freq[i] + 1;
+    build_code_lengths(freq, plain);
+    build_code_lengths(fb, padded);
+    uint64_t base = 0, with_fb = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        base += (uint64_t)freq[i] * (uint64_t)plain[i];
+        with_fb += (uint64_t)freq[i] * (uint64_t)padded[i];
+    }
+    if (with_fb * 100 > base * (100 + SAMPLE_MAX_FALLBACK_PCT)) return 0;
+    memcpy(freq, fb, sizeof(fb));
+    return 1;
+}
+
+size_t compress_block(const unsigned char* in, size_t n, const BlockOptions* opt, unsigned char* out) {
+    int freq[MAX_SYMBOLS] = {0};
+    int full[MAX_SYMBOLS] = {0};   // 抽樣時另外數的完整直方圖，只給 --stats 算熵和損失
+    int lengths[MAX_SYMBOLS];
+    HuffStats* st = opt->stats;
+    double t = st ? stats_now() : 0.0;
+    int sampled = opt->sample > 1 && n >= SAMPLE_MIN_BLOCK;
+    size_t counted = n;   // freq 的總和
+    if (sampled) {
+        counted = sample_block_frequency(in, n, opt->sample, freq) + MAX_SYMBOLS;
+        if (!add_sample_fallback(freq)) {
+            memset(freq, 0, sizeof(freq));
+            sampled = 0;
+            counted = n;
+        }
+    }
+    if (!sampled) count_block_frequency(in, n, freq);
+    if (st) t = stats_lap(st, STAT_COUNT, t);
+
+    // 碼長直接由排序後的頻率算出；超過 L (沒給就是 HUFF_MAX_BITS) 才用 package-merge
+    build_code_lengths(freq, lengths);
+    if (st) t = stats_lap(st, STAT_LENGTHS, t);
+    int limit_L = opt->limit_L;
+    if (limit_L <= 0 || limit_L > HUFF_MAX_BITS) limit_L = HUFF_MAX_BITS;
+    int max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (lengths[i] > max_len) max_len = lengths[i];
+    }
+    if (max_len > limit_L && limit_code_lengths(freq, lengths, limit_L) != 0) {
+        return 0;
+    }
+    if (st) {
+        t = stats_lap(st, STAT_LIMIT, t);
+        st->blocks++;
+        // 抽樣時為了算熵和損失多數一次完整的直方圖，不算進任何階段
+        if (sampled) {
+            count_block_frequency(in, n, full);
+            t = stats_now();
+        }
+        for (int i = 0; i < MAX_SYMBOLS; i++) st->freq[i] += (uint64_t)(sampled ? full[i] : freq[i]);
+    }
+
+    // 其他模型都跟 order-0 的確切大小比，比較小才用；抽樣時只能照比例放大估計
+    unsigned char table[LENGTH_TABLE_MAX];
+    uint64_t bits0 = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) bits0 += (uint64_t)freq[i] * (uint64_t)lengths[i];
+    if (sampled) bits0 = bits0 * n / counted;
+    size_t table0 = put_length_table(lengths, table);
+    size_t size0 = table0 + (size_t)((bits0 + 7) / 8);
+
+    // -e ans：同一個直方圖正規化成 tANS 的表，估計比 Huffman 小就改用它當 order-0
+    AnsModel ans;
+    int use_ans = 0;
+    if (opt->backend == BACKEND_ANS && !sampled) {
+        ans_build(freq, n, &ans);
+        if (ans.size < size0) {
+            use_ans = 1;
+            size0 = ans.size;
+        }
+        if (st) t = stats_lap(st, STAT_LENGTHS, t);
+    }
+
+    // 估計出來沒有比原始資料小 (已經壓過、加密、隨機)：直接存原始資料，不用編碼
+    // 其他模型也要比原始大小還小才用
+    int stored = size0 >= n;
+    if (stored) {
+        size0 = n;
+        use_ans = 0;
+    }
+    if (opt->lz_level > 0 && n >= LZ_MIN_BLOCK) {
+        size_t comp = lz_block(in, n, opt, size0, out + BLOCK_HEADER_MAX);
+        if (comp) return finish_block(out, BLOCK_LZ77, n, comp);
+        if (st) t = stats_now();
+    }
+    if (opt->rle) {
+        size_t comp = rle_block(in, n, opt, size0, out + BLOCK_HEADER_MAX);
+        if (comp) return finish_block(out, BLOCK_RLE, n, comp);
+        if (st) t = stats_now();
+    }
+
+    // order-1：分組的時間算在 lengths
+    if (opt->order == 1 && n >= ORDER1_MIN_BLOCK) {
+        Order1Model* m = (Order1Model*)malloc(sizeof(Order1Model));
+        if (m && order1_build(in, n, opt->limit_L, m) == 0) {
+            if (m->size < size0) {
+                if (st) t = stats_lap(st, STAT_LENGTHS, t);
+                size_t comp = order1_encode(in, n, m, out + BLOCK_HEADER_MAX);
+                if (st) {
+                    stats_lap(st, STAT_ENCODE, t);
+                    st->payload_bits += m->bits;
+                    st->table_bytes += m->size - (size_t)((m->bits + 7) / 8);
+                }
+                free(m);
+                return finish_block(out, BLOCK_ORDER1, n, comp);
+            }
+        }
+        free(m);
+        if (st) stats_lap(st, STAT_LENGTHS, t);
+    }
+    if (stored) {
+        memcpy(out + BLOCK_HEADER_MAX, in, n);
+        if (st) {
+            stats_lap(st, STAT_ENCODE, t);
+            st->payload_bits += 8 * (uint64_t)n;
+            if (sampled) record_sample_loss(st, full, limit_L, 8 * (uint64_t)n);
+        }
+        return finish_block(out, BLOCK_STORED, n, n);
+    }
+    if (use_ans) {
+        size_t comp = ans_encode(in, n, &ans, out + BLOCK_HEADER_MAX);
+        if (comp) {
+            if (st) {
+                stats_lap(st, STAT_ENCODE, t);
+                st->payload_bits += ans.bits;
+                st->table_bytes += ans.size - (size_t)((ans.bits + 7) / 8);
+            }
+            return finish_block(out, BLOCK_ANS, n, comp);
+        }
+    }
+    if (!sampled) {
+        if (st) st->payload_bits += bits0;
+        return encode_block(in, n, lengths, opt->streams, out, st);
+    }
+
+    // 抽樣的碼：估計可能太樂觀，bitstream 超過 n byte 就改存原始資料
+    size_t total = encode_huffman(in, n, lengths, opt->streams, n, out, st);
+    int kept = total != 0;
+    if (!kept) {
+        memcpy(out + BLOCK_HEADER_MAX, in, n);
+        total = finish_block(out, BLOCK_STORED, n, n);
+    }
+    if (st) {
+        // 實際花的 bit 數由完整直方圖算
+        uint64_t bits = 8 * (uint64_t)n;
+        uint64_t cost = bits;
+        if (kept) {
+            bits = 0;
+            for (int i = 0; i < MAX_SYMBOLS; i++) bits += (uint64_t)full[i] * (uint64_t)lengths[i];
+            cost = bits + 8 * (uint64_t)table0;
+        }
+        st->payload_bits += bits;
+        record_sample_loss(st, full, limit_L, cost);
+    }
+    return total;
+}
+
+// encode_block 的本體；bitstream (4 條加起來) 可能超過 cap byte 時放棄，回傳 0
+static size_t encode_huffman(const unsigned char* in, size_t n, const int lengths[MAX_SYMBOLS], int streams,
+                             size_t cap, unsigned char* out, HuffStats* stats) {
+    double t = stats ? stats_now() : 0.0;
+    CodeEntry codes[MAX_SYMBOLS];
+    generate_limited_codes(lengths, codes);
+    int max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (lengths[i] > max_len) max_len = lengths[i];
+    }
+
+    // block 頭是變長的，內容先放在最長的 block 頭後面，最後再往前搬
+    unsigned char* p = out + BLOCK_HEADER_MAX;
+    size_t table_size = put_length_table(lengths, p);
+    if (stats) t = stats_lap(stats, STAT_CODES, t);
+    size_t bits_size;
+    int type;
+    if (streams == 4 && n >= STREAM4_MIN_BLOCK) {
+        // 4 段各自編碼，跳躍表記前 3 條的長度，解碼端才找得到每條的起點
+        size_t seg[4];
+        stream4_split(n, seg);
+        unsigned char* jump = p + table_size;
+        unsigned char* q = jump + JUMP_TABLE_SIZE;
+        const unsigned char* src = in;
+        size_t used = 0;
+        for (int s = 0; s < 4; s++) {
+            size_t m;
+            if (cap == SIZE_MAX) m = encode_buffer(src, seg[s], codes, q);
+            else if ((m = encode_buffer_capped(src, seg[s], codes, max_len, q, cap - used)) == 0) return 0;
+            if (s < 3) put_le32(jump + 4 * s, (uint32_t)m);
+            src += seg[s];
+            q += m;
+            used += m;
+        }
+        bits_size = (size_t)(q - jump);
+        type = BLOCK_HUFFMAN4;
+    }
+    else {
+        if (cap == SIZE_MAX) bits_size = encode_buffer(in, n, codes, p + table_size);
+        else if ((bits_size = encode_buffer_capped(in, n, codes, max_len, p + table_size, cap)) == 0) return 0;
+        type = BLOCK_HUFFMAN;
+    }
+
+    if (stats) {
+        stats_lap(stats, STAT_ENCODE, t);
+        stats->table_bytes += table_size;
+    }
+    return finish_block(out, type, n, table_size + bits_size);
+}
+
+size_t encode_block(const unsigned char* in, size_t n, const int lengths[MAX_SYMBOLS], int streams,
+                    unsigned char* out, HuffStats* stats) {
+    return encode_huffman(in, n, lengths, streams, SIZE_MAX, out, stats);
+}
+
+// 讀跳躍表，切出 4 條 stream；長度對不上回傳 -1
+static int split_streams(const unsigned char* p, size_t avail, const unsigned char* in[4], size_t len[4]) {
+    if (avail < JUMP_TABLE_SIZE) return -1;
+    const unsigned char* q = p + JUMP_TABLE_SIZE;
+    size_t rest = avail - JUMP_TABLE_SIZE;
+    for (int s = 0; s < 3; s++) {
+        len[s] = get_le32(p + 4 * s);
+        if (len[s] > rest) return -1;
+        in[s] = q;
+        q += len[s];
+        rest -= len[s];
+    }
+    in[3] = q;
+    len[3] = rest;
+    return 0;
+}
+
+// 一次解 RLE_CHUNK 個 byte 到堆疊上的小緩衝區，馬上還原到 out；解出的長度要剛好是 rle_size，還原後剛好 n
+static int decode_rle(const unsigned char* in, size_t in_len, const DecodeTable* dt, uint64_t rle_size,
+                      unsigned char* out, size_t n) {
+    unsigned char chunk[RLE_CHUNK];
+    BitReader br;
+    RleDecoder rd;
+    br_init_mem(&br, in, in_len);
+    rle_decoder_init(&rd);
+    size_t done = 0;
+    while (rle_size > 0) {
+        size_t want = rle_size < RLE_CHUNK ? (size_t)rle_size : RLE_CHUNK;
+        size_t made;
+        if (br_decode_bytes(&br, dt, chunk, want) != want ||
+            rle_expand(&rd, chunk, want, out + done, n - done, &made) != 0) return -1;
+        done += made;
+        rle_size -= want;
+    }
+    return (done == n && rle_finished(&rd)) ? 0 : -1;
+}
+
+int decode_block(const BlockHeader* bh, const unsigned char* payload, unsigned char* out) {
+    DecodeTable dt;
+    memset(&dt, 0, sizeof(dt));
+    int rc = decode_block_with(bh, payload, out, &dt, NULL);
+    free_decode_table(&dt);
+    return rc;
+}
+
+int decode_block_with(const BlockHeader* bh, const unsigned char* payload, unsigned char* out,
+                      DecodeTable* dt, HuffStats* stats) {
+    double t = stats ? stats_now() : 0.0;
+    if (bh->type == BLOCK_ORDER1 || bh->type == BLOCK_LZ77) {
+        // 這兩種都有好幾張表，是 order1_decode / lz_decode 自己建的，時間都算在 decode
+        int rc = (bh->type == BLOCK_ORDER1) ? order1_decode(payload, bh->comp_size, out, bh->raw_size)
+                                            : lz_decode(payload, bh->comp_size, out, bh->raw_size);
+        if (stats) {
+            stats_lap(stats, STAT_DECODE, t);
+            stats->payload_bits += 8 * (uint64_t)bh->comp_size;
+            stats->blocks++;
+        }
+        return rc == 0 ? 0 : -4;
+    }
+    if (bh->type == BLOCK_STORED) {
+        if (bh->comp_size != bh->raw_size) return -2;
+        memcpy(out, payload, bh->raw_size);
+        if (stats) {
+            stats_lap(stats, STAT_DECODE, t);
+            stats->payload_bits += 8 * (uint64_t)bh->comp_size;
+            stats->blocks++;
+        }
+        return 0;
+    }
+    if (bh->type == BLOCK_ANS) {
+        size_t bytes = 0;
+        int rc = ans_decode(payload, bh->comp_size, out, bh->raw_size, &bytes);
+        if (stats) {
+            stats_lap(stats, STAT_DECODE, t);
+            if (bytes > stats->decode_table_bytes) stats->decode_table_bytes = bytes;
+            stats->payload_bits += 8 * (uint64_t)bh->comp_size;
+            stats->blocks++;
+        }
+        return rc == 0 ? 0 : -4;
+    }
+    if (bh->type != BLOCK_HUFFMAN && bh->type != BLOCK_HUFFMAN4 && bh->type != BLOCK_RLE) return -1;
+
+    // RLE block 前面多一個 RLE 之後的長度
+    uint64_t rle_size = 0;
+    int head = 0;
+    if (bh->type == BLOCK_RLE) {
+        head = get_varint(payload, bh->comp_size, &rle_size);
+        if (head < 0) return -2;
+    }
+    int lengths[MAX_SYMBOLS];
+    int used = get_length_table(payload + head, bh->comp_size - (size_t)head, lengths);
+    if (used < 0) return -2;
+    used += head;
+
+    if (rebuild_decode_table(dt, lengths) != 0) return -3;
+    build_multi_table(dt);   // 平均碼長夠短才會建；建不了就一次解一個
+    if (stats) {
+        t = stats_lap(stats, STAT_TABLE, t);
+        size_t bytes = (size_t)dt->num_entries * sizeof(DecodeEntry) + (size_t)dt->num_subs * sizeof(uint32_t);
+        if (dt->multi) bytes += sizeof(MultiEntry) << MULTI_LOOKUP_BITS;
+        if (bytes > stats->decode_table_bytes) stats->decode_table_bytes = bytes;
+        stats->table_bytes += (uint64_t)used;
+        stats->blocks++;
+    }
+    const unsigned char* bits = payload + used;
+    size_t bits_len = bh->comp_size - (size_t)used;
+    int rc;
+    if (bh->type == BLOCK_HUFFMAN4) {
+        const unsigned char* in[4];
+        size_t len[4];
+        rc = split_streams(bits, bits_len, in, len);
+        if (rc == 0) rc = decode_buffer4(in, len, dt, out, bh->raw_size);
+    }
+    else if (bh->type == BLOCK_RLE) {
+        rc = decode_rle(bits, bits_len, dt, rle_size, out, bh->raw_size);
+    }
+    else {
+        rc = decode_buffer(bits, bits_len, dt, out, bh->raw_size);
+    }
+    if (stats) {
+        stats_lap(stats, STAT_DECODE, t);
+        stats->payload_bits += 8 * (uint64_t)(bits_len - (bh->type == BLOCK_HUFFMAN4 ? JUMP_TABLE_SIZE : 0));
+    }
+    return rc == 0 ? 0 : -4;
+}
+
+// 第 1 版的碼長表：32 byte 的 bitmap 標出有哪些符號，再依序每個符號 5 bit 的 (長度 - 1)，MSB first
+// 回傳碼長表用掉的 byte 數；資料不夠回傳 -1
+static int get_length_table_v1(const unsigned char* in, size_t avail, int lengths[MAX_SYMBOLS]) {
+    const size_t bitmap = MAX_SYMBOLS / 8;
+    if (avail < bitmap) return -1;
+    int num = 0;
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        if (in[s >> 3] & (1u << (s & 7))) num++;
+    }
+    size_t need = bitmap + ((size_t)num * 5 + 7) / 8;
+    if (avail < need) return -1;
+
+    const unsigned char* p = in + bitmap;
+    size_t bitpos = 0;
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        lengths[s] = 0;
+        if (!(in[s >> 3] & (1u << (s & 7)))) continue;
+        int v = 0;
+        for (int b = 0; b < 5; b++, bitpos++) {
+            v = (v << 1) | ((p[bitpos >> 3] >> (7 - (bitpos & 7))) & 1);
+        }
+        lengths[s] = v + 1;
+    }
+    return (int)need;
+}
+
+// 第 1 版只有 Huffman / 4-stream 兩種 block，除了碼長表以外跟 decode_block 一樣；
+// 舊格式不會再變，所以單獨留一份，不跟著 decode_block 改
+int decode_block_v1(const BlockHeader* bh, const unsigned char* payload, unsigned char* out) {
+    if (bh->type != BLOCK_HUFFMAN && bh->type != BLOCK_HUFFMAN4) return -1;
+
+    int lengths[MAX_SYMBOLS];
+    int used = get_length_table_v1(payload, bh->comp_size, lengths);
+    if (used < 0) return -2;
+
+    DecodeTable dt;
+    if (build_decode_table(&dt, lengths) != 0) return -3;
+    const unsigned char* bits = payload + used;
+    size_t bits_len = bh->comp_size - (size_t)used;
+    int rc;
+    if (bh->type == BLOCK_HUFFMAN4) {
+        const unsigned char* in[4];
+        size_t len[4];
+        rc = split_streams(bits, bits_len, in, len);
+        if (rc == 0) rc = decode_buffer4(in, len, &dt, out, bh->raw_size);
+    }
+    else {
+        rc = decode_buffer(bits, bits_len, &dt, out, bh->raw_size);
+    }
+    free_decode_table(&dt);
+    return rc == 0 ? 0 : -4;
+}
+
+// ==========================================
+// 4. Block 索引
+// ==========================================
+
+void index_init(BlockIndex* idx, uint64_t first_offset) {
+    idx->entries = NULL;
+    idx->count = idx->cap = 0;
+    idx->comp_pos = first_offset;
+    idx->raw_pos = 0;
+}
+
+int index_add(BlockIndex* idx, uint32_t raw_size, uint32_t comp_size) {
+    if (idx->count == idx->cap) {
+        size_t cap = idx->cap ? idx->cap * 2 : 64;
+        IndexEntry* p = (IndexEntry*)realloc(idx->entries, cap * sizeof(IndexEntry));
+        if (!p) return -1;
+        idx->entries = p;
+        idx->cap = cap;
+    }
+    IndexEntry* e = &idx->entries[idx->count++];
+    e->comp_offset = idx->comp_pos;
+    e->raw_offset = idx->raw_pos;
+    e->raw_size = raw_size;
+    e->comp_size = comp_size;
+    idx->comp_pos += comp_size;
+    idx->raw_pos += raw_size;
+    return 0;
+}
+
+void index_free(BlockIndex* idx) {
+    free(idx->entries);
+    idx->entries = NULL;
+    idx->count = idx->cap = 0;
+}
+
+int index_write(FILE* fout, const BlockIndex* idx, uint64_t index_offset) {
+    unsigned char buf[INDEX_ENTRY_SIZE];
+    for (size_t i = 0; i < idx->count; i++) {
+        const IndexEntry* e = &idx->entries[i];
+        put_le64(buf, e->comp_offset);
+        put_le64(buf + 8, e->raw_offset);
+        put_le32(buf + 16, e->raw_size);
+        put_le32(buf + 20, e->comp_size);
+        if (fwrite(buf, 1, INDEX_ENTRY_SIZE, fout) != INDEX_ENTRY_SIZE) return -1;
+    }
+    put_le64(buf, index_offset);
+    put_le32(buf + 8, (uint32_t)idx->count);
+    memcpy(buf + 12, INDEX_MAGIC, 4);
+    if (fwrite(buf, 1, INDEX_FOOTER_SIZE, fout) != INDEX_FOOTER_SIZE) return -1;
+    return 0;
+}
+
+int file_seek(FILE* fp, int64_t off, int whence) {
+#ifdef _WIN32
+    return _fseeki64(fp, off, whence);
+#else
+    return fseeko(fp, (off_t)off, whence);
+#endif
+}
+
+int index_read(FILE* fin, const ContainerHeader* ch, BlockIndex* idx) {
+    unsigned char buf[INDEX_ENTRY_SIZE];
+    index_init(idx, ch->header_size);
+    if (!(ch->flags & HUF2_FLAG_INDEX)) return -1;
+    if (file_seek(fin, -INDEX_FOOTER_SIZE, SEEK_END) != 0) return -2;
+    if (fread(buf, 1, INDEX_FOOTER_SIZE, fin) != INDEX_FOOTER_SIZE) return -3;
+    if (memcmp(buf + 12, INDEX_MAGIC, 4) != 0) return -4;
+    uint64_t index_offset = get_le64(buf);
+    uint32_t count = get_le32(buf + 8);
+    if (file_seek(fin, (int64_t)index_offset, SEEK_SET) != 0) return -5;
+
+    // 逐項讀回來，同時檢查位置是否接得起來
+    for (uint32_t i = 0; i < count; i++) {
+        if (fread(buf, 1, INDEX_ENTRY_SIZE, fin) != INDEX_ENTRY_SIZE ||
+            index_add(idx, get_le32(buf + 16), get_le32(buf + 20)) != 0) {
+            index_free(idx);
+            return -6;
+        }
+        const IndexEntry* e = &idx->entries[i];
+        if (get_le64(buf) != e->comp_offset || get_le64(buf + 8) != e->raw_offset ||
+            e->raw_size == 0 || e->raw_size > ch->block_size ||
+            e->comp_size < BLOCK_HEADER_MIN || e->comp_size > block_bound(ch->block_size)) {
+            index_free(idx);
+            return -7;
+        }
+    }
+    if ((ch->original_size != HUF2_SIZE_UNKNOWN && idx->raw_pos != ch->original_size) ||
+        idx->comp_pos + BLOCK_END_SIZE != index_offset) {
+        index_free(idx);
+        return -8;
+    }
+    return 0;
+}
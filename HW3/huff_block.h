@@ -0,0 +1,188 @@
+// huff_block.h - HUF2 分塊容器格式
+//
+// 檔案 = 檔頭 + 一個個 block + 結束 block
+//   檔頭 : "HUF2" | version | flags | limit_L | block_size (KiB，varint) | original_size (varint)
+//   flags 有 HUF2_FLAG_STREAM 時沒有 original_size，總長度以結束 block 為準
+//   block 頭 : type | raw_size (varint) | comp_size (varint)；結束 block 只有 type 一個 byte
+//   Huffman block 內容 : 碼長表 (見 huff_core.h) + bitstream (共 comp_size bytes)
+//   4-stream block 內容 : 碼長表 + 跳躍表 (前 3 條 stream 的 byte 數，各 4 bytes) + 4 條 bitstream
+//                         原始資料切成 4 段 (stream4_split)，各自編成一條 bitstream
+//   order-1 block 內容  : 見 huff_order1.h
+//   RLE block 內容      : 見 huff_rle.h (raw_size 還是原始大小)
+//   LZ77 block 內容     : 見 huff_lz77.h
+//   tANS block 內容     : 見 huff_ans.h
+//   stored block 內容   : 原始資料照抄 (comp_size == raw_size)
+// flags 有 HUF2_FLAG_INDEX 時 (不只一個 block 才會有)，結束 block 後面接 block 索引和固定 16 byte 的檔尾：
+//   索引項 (24 bytes) : comp_offset (8) | raw_offset (8) | raw_size (4) | comp_size (4，含 block 頭)
+//   檔尾 (16 bytes)   : 索引起點 (8) | block 數 (4) | "HUFX"
+// 固定長度的整數都是 little-endian
+//
+// 第 1 版 (HUF2_VERSION_V1) 的檔案只留解壓縮，只能照順序解：
+//   檔頭 (20 bytes) : "HUF2" | version | flags | limit_L | 保留 | block_size (4) | original_size (8)
+//   block 頭 (9 bytes) : type | raw_size (4) | comp_size (4)；結束 block 也是 9 bytes
+//   碼長表 : 32 byte 的符號 bitmap + 每個出現過的符號 5 bit 的 (長度 - 1)
+#ifndef HUFF_BLOCK_H
+#define HUFF_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_core.h"
+#include "huff_stats.h"
+
+#define HUF2_MAGIC         "HUF2"
+#define HUF2_VERSION       2
+#define HUF2_HEADER_MAX    (7 + 2 * VARINT_MAX)
+#define BLOCK_HEADER_MAX   (1 + 2 * 5)   // 兩個 32 bit 的 varint
+#define BLOCK_HEADER_MIN   3
+#define BLOCK_END_SIZE     1
+
+// 第 1 版 (只讀不寫)
+#define HUF2_VERSION_V1      1
+#define HUF2_V1_HEADER_SIZE  20
+#define BLOCK_V1_HEADER_SIZE 9
+
+#define DEFAULT_BLOCK_SIZE (1u << 20)   // 1 MiB
+#define MIN_BLOCK_SIZE     (128u << 10) // 128 KiB
+#define MAX_BLOCK_SIZE     (4u << 20)   // 4 MiB
+
+#define INDEX_ENTRY_SIZE   24
+#define INDEX_FOOTER_SIZE  16
+#define INDEX_MAGIC        "HUFX"
+
+// 檔頭 flags
+#define HUF2_FLAG_INDEX  0x01   // 檔尾有 block 索引
+#define HUF2_FLAG_STREAM 0x02   // 從 pipe 壓縮，壓縮時不知道原始大小
+
+#define HUF2_SIZE_UNKNOWN UINT64_MAX
+
+// block 種類
+#define BLOCK_HUFFMAN  0
+#define BLOCK_HUFFMAN4 1   // 4 條交錯 bitstream
+#define BLOCK_ORDER1   2   // 依前一個 byte 分組，每組一張碼表
+#define BLOCK_RLE      3   // 先做 run-length 再 Huffman
+#define BLOCK_LZ77     4   // LZ77 序列，literal / 長度 / 距離各一張碼表
+#define BLOCK_ANS      5   // order-0 改用 tANS 編碼
+#define BLOCK_STORED   6   // 壓不小：存原始資料
+#define BLOCK_END      0xFF
+
+// order-0 的熵編碼 (-e)
+#define BACKEND_HUFFMAN 0
+#define BACKEND_ANS     1
+
+// 抽樣統計頻率 (-f)：只數 1/stride 的 byte 建碼表，省掉大部分的統計時間，代價是碼表沒那麼準
+// 樣本沒看到的 byte 也給一個長碼；抽樣的碼可能編出比原始還大的東西，超過就改存原始資料
+#define SAMPLE_MAX_STRIDE  256
+#define SAMPLE_MIN_BLOCK   (64u << 10)  // 比這小的 block 還是全部數
+#define SAMPLE_MAX_FALLBACK_PCT 1       // 保底碼讓樣本多花超過這個百分比就改成全部數
+
+#define JUMP_TABLE_SIZE    12
+#define STREAM4_MIN_BLOCK  256   // 太小的 block 分 4 條不划算，還是用 1 條
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    uint8_t  version;
+    uint8_t  flags;
+    uint8_t  limit_L;        // 0 = 沒有限制
+    uint32_t block_size;     // 每個 block 最多幾個原始 byte
+    uint64_t original_size;  // 原始檔案大小，不知道時是 HUF2_SIZE_UNKNOWN
+    uint32_t header_size;    // 檔頭的 byte 數 (含 magic)，讀寫時填入
+} ContainerHeader;
+
+// 壓縮選項 (每個 block 都一樣)
+typedef struct {
+    int limit_L;   // 最長碼長，<= 0 表示不限制
+    int streams;   // 1 或 4 條 bitstream
+    int order;     // 1 = 試 order-1 context 模型，比較小才用 (0 = 只用 order-0)
+    int rle;       // 1 = 先試 run-length 前處理，比較小才用
+    int lz_level;  // 1..LZ_MAX_LEVEL = 先試 LZ77 (越大找越久)，0 = 不用
+    int lz_window; // LZ77 window 的 bit 數，0 = LZ_DEFAULT_WINDOW
+    int backend;   // BACKEND_HUFFMAN / BACKEND_ANS (tANS 估計比較小才用)
+    int sample;    // 2..SAMPLE_MAX_STRIDE = order-0 的碼表只由 1/sample 的 byte 統計 (只用 Huffman)，0 = 全部數
+    HuffStats* stats;   // 不是 NULL 時記錄各階段時間 (同一份不能給兩條 thread 同時用)
+} BlockOptions;
+
+typedef struct {
+    uint8_t  type;
+    uint32_t raw_size;   // 解壓後大小
+    uint32_t comp_size;  // block 頭後面還有幾個 byte
+} BlockHeader;
+
+// 一個 block 在壓縮檔和原始檔裡的位置
+typedef struct {
+    uint64_t comp_offset;  // block 頭在壓縮檔的位置
+    uint64_t raw_offset;   // 解開後在原始檔的位置
+    uint32_t raw_size;
+    uint32_t comp_size;    // 含 block 頭
+} IndexEntry;
+
+// 邊壓邊記錄的 block 索引
+typedef struct {
+    IndexEntry* entries;
+    size_t count, cap;
+    uint64_t comp_pos;     // 下一個 block 的 comp_offset
+    uint64_t raw_pos;      // 下一個 block 的 raw_offset
+} BlockIndex;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+// --- 小工具：little-endian 讀寫 ---
+void put_le32(unsigned char* p, uint32_t v);
+void put_le64(unsigned char* p, uint64_t v);
+uint32_t get_le32(const unsigned char* p);
+uint64_t get_le64(const unsigned char* p);
+/* 支援超過 2GB 的 fseek */
+int file_seek(FILE* fp, int64_t off, int whence);
+
+// --- 檔頭 / block 頭 ---
+/* 回傳檔頭 byte 數 (同時填進 ch->header_size) */
+size_t put_container_header(unsigned char out[HUF2_HEADER_MAX], ContainerHeader* ch);
+/* in 是 "HUF2" 之後的資料；回傳用掉的 byte 數，格式不對回傳負值 */
+int    get_container_header(const unsigned char* in, size_t avail, ContainerHeader* ch);
+/* magic 已經讀掉，從檔案讀剩下的檔頭；格式不對回傳負值
+   第 1 版的檔頭也認得 (ch->version 是 HUF2_VERSION_V1)，get_container_header 只認得目前的版本 */
+int    read_container_header(FILE* fin, ContainerHeader* ch);
+/* 回傳 block 頭 byte 數 */
+size_t put_block_header(unsigned char out[BLOCK_HEADER_MAX], const BlockHeader* bh);
+/* 回傳用掉的 byte 數，資料不夠或壞掉回傳 -1 */
+int    get_block_header(const unsigned char* in, size_t avail, BlockHeader* bh);
+int    read_block_header(FILE* fin, BlockHeader* bh);
+/* 第 1 版的 block 頭 (固定 9 byte)；讀不到回傳 -1 */
+int    read_block_header_v1(FILE* fin, BlockHeader* bh);
+
+// --- block 編碼 / 解碼 ---
+/* 原始 n byte 的 block 壓縮後最多會用到多少 byte (含 block 頭) */
+size_t block_bound(size_t n);
+
+/* 統計頻率 → 算碼長 → 限制長度 → 編碼，一次做完一個 block
+   回傳寫進 out 的 byte 數；limit_L 太小裝不下所有符號時回傳 0 */
+size_t compress_block(const unsigned char* in, size_t n, const BlockOptions* opt, unsigned char* out);
+
+/* 用給定的碼長把 in 編成一個完整的 Huffman block (含 block 頭)，回傳總 byte 數
+   streams 是 4 而且 block 夠大時編成 4-stream block */
+size_t encode_block(const unsigned char* in, size_t n, const int lengths[MAX_SYMBOLS], int streams,
+                    unsigned char* out, HuffStats* stats);
+
+/* 解一個 block 的內容 (block 頭後面的 comp_size byte) 到 out；資料壞掉回傳負值 */
+int decode_block(const BlockHeader* bh, const unsigned char* payload, unsigned char* out);
+/* 同上，但解碼表建在呼叫端的 dt 裡 (一開始清成 0)，連續解很多 block 時不用每次配置；用完 free_decode_table
+   stats 不是 NULL 時記錄建表和解碼的時間 */
+int decode_block_with(const BlockHeader* bh, const unsigned char* payload, unsigned char* out,
+                      DecodeTable* dt, HuffStats* stats);
+/* 解第 1 版的 block (bitmap 碼長表)，其他同 decode_block；第 1 版的 comp_size 一樣不會超過 block_bound */
+int decode_block_v1(const BlockHeader* bh, const unsigned char* payload, unsigned char* out);
+
+// --- block 索引 ---
+void index_init(BlockIndex* idx, uint64_t first_offset);
+int  index_add(BlockIndex* idx, uint32_t raw_size, uint32_t comp_size);
+void index_free(BlockIndex* idx);
+/* 在目前位置寫出索引和檔尾 (index_offset 是目前位置) */
+int  index_write(FILE* fout, const BlockIndex* idx, uint64_t index_offset);
+/* 從檔尾讀回索引並檢查前後一致；失敗回傳負值 */
+int  index_read(FILE* fin, const ContainerHeader* ch, BlockIndex* idx);
+
+#endif // HUFF_BLOCK_H
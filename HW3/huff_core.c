@@ -0,0 +1,1012 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "huff_core.h"
+
+// ==========================================
+// 0. 頻率統計
+// ==========================================
+
+// 一次拿 8 byte，輪流累加到 4 張表
+#define HIST_STEP8(t, w)                      \
+    do {                                      \
+        t[0][(uint8_t)(w)]++;                 \
+        t[1][(uint8_t)((w) >> 8)]++;          \
+        t[2][(uint8_t)((w) >> 16)]++;         \
+        t[3][(uint8_t)((w) >> 24)]++;         \
+        t[0][(uint8_t)((w) >> 32)]++;         \
+        t[1][(uint8_t)((w) >> 40)]++;         \
+        t[2][(uint8_t)((w) >> 48)]++;         \
+        t[3][(uint8_t)((w) >> 56)]++;         \
+    } while (0)
+
+void count_block_frequency(const unsigned char* buf, size_t n, int freq[MAX_SYMBOLS]) {
+    // 只用一張表時，同一個 byte 連續出現會卡在同一個計數器 (要等上一次寫回才能再加)
+    // 拆成 4 張表輪流加，相鄰 byte 落在不同的表，最後再合併
+    uint32_t t[4][MAX_SYMBOLS];
+    memset(t, 0, sizeof(t));
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint64_t a, b;
+        memcpy(&a, buf + i, 8);
+        memcpy(&b, buf + i + 8, 8);
+        HIST_STEP8(t, a);
+        HIST_STEP8(t, b);
+    }
+    for (; i < n; i++) {
+        t[i & 3][buf[i]]++;
+    }
+
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        freq[s] += (int)(t[0][s] + t[1][s] + t[2][s] + t[3][s]);
+    }
+}
+
+size_t sample_block_frequency(const unsigned char* buf, size_t n, int stride, int freq[MAX_SYMBOLS]) {
+    // 抽連續的一段而不是每隔 stride 個抽一個：沒抽到的 cache line 根本不用讀
+    size_t step = (size_t)SAMPLE_CHUNK * (size_t)stride;
+    size_t total = 0;
+    for (size_t i = 0; i < n; i += step) {
+        size_t m = n - i < SAMPLE_CHUNK ? n - i : SAMPLE_CHUNK;
+        for (size_t j = 0; j < m; j++) freq[buf[i + j]]++;
+        total += m;
+    }
+    return total;
+}
+
+// ==========================================
+// 1. 碼長計算 (Moffat–Katajainen in-place)
+// ==========================================
+
+typedef struct {
+    uint64_t weight;
+    int symbol;
+} SymWeight;
+
+static int cmp_sym_weight(const void* a, const void* b) {
+    const SymWeight* x = (const SymWeight*)a;
+    const SymWeight* y = (const SymWeight*)b;
+    if (x->weight != y->weight) return (x->weight < y->weight) ? -1 : 1;
+    return x->symbol - y->symbol;
+}
+
+// A[] 由小到大排好後原地做三個階段：
+//   1. 合併：A[root] 當作內部節點佇列，A[leaf] 是葉子佇列 (兩個佇列都遞增，所以最小值只在兩個頭)
+//   2. 把父節點索引換成深度
+//   3. 由內部節點深度推回每個葉子的深度
+static void minimum_redundancy(uint64_t A[], int n) {
+    int root = 0, leaf = 2, next;
+
+    A[0] += A[1];
+    for (next = 1; next < n - 1; next++) {
+        // 第一個子節點
+        if (leaf >= n || A[root] < A[leaf]) {
+            A[next] = A[root];
+            A[root++] = (uint64_t)next;
+        }
+        else {
+            A[next] = A[leaf++];
+        }
+        // 第二個子節點
+        if (leaf >= n || (root < next && A[root] < A[leaf])) {
+            A[next] += A[root];
+            A[root++] = (uint64_t)next;
+        }
+        else {
+            A[next] += A[leaf++];
+        }
+    }
+
+    A[n - 2] = 0;
+    for (next = n - 3; next >= 0; next--) {
+        A[next] = A[A[next]] + 1;
+    }
+
+    int avbl = 1, used = 0, dpth = 0;
+    root = n - 2;
+    next = n - 1;
+    while (avbl > 0) {
+        while (root >= 0 && A[root] == (uint64_t)dpth) {
+            used++;
+            root--;
+        }
+        while (avbl > used) {
+            A[next--] = (uint64_t)dpth;
+            avbl--;
+        }
+        avbl = 2 * used;
+        dpth++;
+        used = 0;
+    }
+}
+
+int build_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS]) {
+    SymWeight sw[MAX_SYMBOLS];
+    uint64_t A[MAX_SYMBOLS];
+    int n = 0;
+
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        lengths[i] = 0;
+        if (freq[i] > 0) {
+            sw[n].weight = (uint64_t)freq[i];
+            sw[n].symbol = i;
+            n++;
+        }
+    }
+    if (n == 0) return 0;
+    if (n == 1) {
+        lengths[sw[0].symbol] = 1;
+        return 1;
+    }
+
+    qsort(sw, n, sizeof(SymWeight), cmp_sym_weight);
+    for (int i = 0; i < n; i++) A[i] = sw[i].weight;
+    minimum_redundancy(A, n);
+    for (int i = 0; i < n; i++) lengths[sw[i].symbol] = (int)A[i];
+    return n;
+}
+
+// 每一層的串列 = 所有葉子 + 下一層兩兩打包的 package，依權重合併
+// 最上層取前 2n-2 個：其中葉子各加一層碼長，package 代表要往下一層多取兩個
+// 葉子在每層都是依權重排好的，所以被選到的一定是前 k 個
+int limit_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS], int limit) {
+    SymWeight sw[MAX_SYMBOLS];
+    int n = 0;
+
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        lengths[i] = 0;
+        if (freq[i] > 0) {
+            sw[n].weight = (uint64_t)freq[i];
+            sw[n].symbol = i;
+            n++;
+        }
+    }
+    if (n == 0) return 0;
+    if (n == 1) {
+        lengths[sw[0].symbol] = 1;
+        return 0;
+    }
+    if (limit > HUFF_MAX_BITS) limit = HUFF_MAX_BITS;
+    if (limit < 31 && n > (1 << limit)) return -1;
+    qsort(sw, n, sizeof(SymWeight), cmp_sym_weight);
+
+    // is_pkg[d][j]：第 d 層 (0 = 最上層) 合併後第 j 個是不是 package
+    uint8_t is_pkg[HUFF_MAX_BITS][2 * MAX_SYMBOLS];
+    int list_len[HUFF_MAX_BITS];
+    uint64_t prev[2 * MAX_SYMBOLS], cur[2 * MAX_SYMBOLS];
+    int prev_len;
+
+    // 最底層只有葉子
+    for (int i = 0; i < n; i++) {
+        prev[i] = sw[i].weight;
+        is_pkg[limit - 1][i] = 0;
+    }
+    prev_len = n;
+    list_len[limit - 1] = n;
+
+    for (int d = limit - 2; d >= 0; d--) {
+        int pkgs = prev_len / 2;
+        int li = 0, pi = 0, m = 0;
+        while (li < n || pi < pkgs) {
+            uint64_t pw = (pi < pkgs) ? prev[2 * pi] + prev[2 * pi + 1] : 0;
+            if (pi >= pkgs || (li < n && sw[li].weight <= pw)) {
+                cur[m] = sw[li++].weight;
+                is_pkg[d][m++] = 0;
+            }
+            else {
+                cur[m] = pw;
+                is_pkg[d][m++] = 1;
+                pi++;
+            }
+        }
+        memcpy(prev, cur, sizeof(uint64_t) * m);
+        prev_len = m;
+        list_len[d] = m;
+    }
+
+    // 由上往下挑：每層前 take 個
+    int take = 2 * n - 2;
+    for (int d = 0; d < limit && take > 0; d++) {
+        int leaves = 0, pkgs = 0;
+        if (take > list_len[d]) take = list_len[d];
+        for (int j = 0; j < take; j++) {
+            if (is_pkg[d][j]) pkgs++;
+            else leaves++;
+        }
+        for (int i = 0; i < leaves; i++) lengths[sw[i].symbol]++;
+        take = 2 * pkgs;
+    }
+    return 0;
+}
+
+// ==========================================
+// 2. Canonical 碼值
+// ==========================================
+
+// Canonical：同長度的符號依編號排，碼值連續；直接存整數不轉字串
+void generate_limited_codes(const int lengths[MAX_SYMBOLS], CodeEntry table[MAX_SYMBOLS]) {
+    int bl_count[HUFF_MAX_BITS + 2] = {0};
+    uint32_t next_code[HUFF_MAX_BITS + 2] = {0};
+    int max_len = 0;
+
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (lengths[i] > 0 && lengths[i] <= HUFF_MAX_BITS) {
+            bl_count[lengths[i]]++;
+            if (lengths[i] > max_len) max_len = lengths[i];
+        }
+    }
+    // 計算每個長度的起始 code
+    uint32_t code = 0;
+    for (int len = 1; len <= max_len; len++) {
+        code = (code + bl_count[len - 1]) << 1;
+        next_code[len] = code;
+    }
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        int len = lengths[i];
+        table[i].symbol = (unsigned char)i;
+        table[i].length = (len > 0 && len <= HUFF_MAX_BITS) ? (unsigned char)len : 0;
+        table[i].code = table[i].length ? next_code[len]++ : 0;
+    }
+}
+
+void code_to_string(unsigned int code, int length, char* out) {
+    for (int b = length - 1; b >= 0; b--) {
+        *out++ = ((code >> b) & 1) ? '1' : '0';
+    }
+    *out = '\0';
+}
+
+// ==========================================
+// 3. 兩層查表解碼器
+// ==========================================
+
+// 第一層看 root_bits 個 bit，長度 <= root_bits 的碼一次查到；
+// 更長的碼用前 root_bits 個 bit 當前綴，接到自己的第二層子表
+int build_decode_table(DecodeTable* t, const int lengths[MAX_SYMBOLS]) {
+    memset(t, 0, sizeof(*t));
+    return rebuild_decode_table(t, lengths);
+}
+
+int rebuild_decode_table(DecodeTable* t, const int lengths[MAX_SYMBOLS]) {
+    t->root_bits = t->max_len = 0;
+    t->num_entries = t->num_subs = 0;
+    t->multi = NULL;
+
+    int bl_count[HUFF_MAX_BITS + 1] = {0};
+    int max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (lengths[i] < 0 || lengths[i] > HUFF_MAX_BITS) return -1;
+        if (lengths[i] > 0) {
+            bl_count[lengths[i]]++;
+            if (lengths[i] > max_len) max_len = lengths[i];
+        }
+    }
+    if (max_len == 0) return 0; // 空檔案：沒有符號
+
+    // Kraft 檢查：碼不能超額 (不足是允許的，只有一個符號時就會發生)
+    int64_t left = 1;
+    for (int len = 1; len <= max_len; len++) {
+        left = (left << 1) - bl_count[len];
+        if (left < 0) return -2;
+    }
+
+    CodeEntry codes[MAX_SYMBOLS];
+    generate_limited_codes(lengths, codes);
+
+    int root = (max_len < HUFF_LOOKUP_BITS) ? max_len : HUFF_LOOKUP_BITS;
+    int root_size = 1 << root;
+
+    // 每個前綴底下最長的碼決定子表大小
+    uint8_t need[1 << HUFF_LOOKUP_BITS];
+    memset(need, 0, sizeof(need));
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        int len = codes[s].length;
+        if (len > root) {
+            uint32_t prefix = codes[s].code >> (len - root);
+            if (len - root > need[prefix]) need[prefix] = (uint8_t)(len - root);
+        }
+    }
+    int64_t total = root_size;
+    int num_subs = 0;
+    for (int p = 0; p < root_size; p++) {
+        if (need[p]) {
+            total += (int64_t)1 << need[p];
+            num_subs++;
+        }
+    }
+
+    // 空間不夠才重新配置；沿用時要把上一次的內容清掉 (長度 0 = 不存在的碼)
+    if (total > t->cap_entries || num_subs > t->cap_subs) {
+        free_decode_table(t);
+        t->entries = (DecodeEntry*)malloc(sizeof(DecodeEntry) * (size_t)total);
+        t->sub_base = (uint32_t*)malloc(sizeof(uint32_t) * (num_subs ? num_subs : 1));
+        if (!t->entries || !t->sub_base) {
+            free_decode_table(t);
+            return -3;
+        }
+        t->cap_entries = (int)total;
+        t->cap_subs = num_subs ? num_subs : 1;
+    }
+    memset(t->entries, 0, sizeof(DecodeEntry) * (size_t)total);
+    t->root_bits = root;
+    t->max_len = max_len;
+    t->num_entries = (int)total;
+    t->num_subs = num_subs;
+
+    // 先把子表指標放進第一層
+    uint32_t base = (uint32_t)root_size;
+    int sub = 0;
+    for (int p = 0; p < root_size; p++) {
+        if (need[p]) {
+            t->entries[p].symbol = (uint16_t)sub;
+            t->entries[p].sub_bits = need[p];
+            t->sub_base[sub++] = base;
+            base += 1u << need[p];
+        }
+    }
+
+    // 再把每個符號填進它涵蓋的所有格子
+    for (int s = 0; s < MAX_SYMBOLS; s++) {
+        int len = codes[s].length;
+        if (len == 0) continue;
+        DecodeEntry e = { (uint16_t)s, (uint8_t)len, 0 };
+        if (len <= root) {
+            uint32_t start = codes[s].code << (root - len);
+            uint32_t cnt = 1u << (root - len);
+            for (uint32_t k = 0; k < cnt; k++) t->entries[start + k] = e;
+        }
+        else {
+            int extra = len - root;
+            uint32_t prefix = codes[s].code >> extra;
+            DecodeEntry* head = &t->entries[prefix];
+            DecodeEntry* subt = &t->entries[t->sub_base[head->symbol]];
+            uint32_t low = codes[s].code & ((1u << extra) - 1);
+            uint32_t start = low << (head->sub_bits - extra);
+            uint32_t cnt = 1u << (head->sub_bits - extra);
+            for (uint32_t k = 0; k < cnt; k++) subt[start + k] = e;
+        }
+    }
+    return 0;
+}
+
+void free_decode_table(DecodeTable* t) {
+    free(t->entries);
+    free(t->sub_base);
+    free(t->multi_store);
+    t->entries = NULL;
+    t->sub_base = NULL;
+    t->multi = t->multi_store = NULL;
+    t->cap_entries = t->cap_subs = 0;
+}
+
+int build_multi_table(DecodeTable* t) {
+    t->multi = NULL;
+    if (t->max_len == 0) return 0;
+    // 長度 len 的碼在第一層佔 2^(root - len) 格，剛好是 2^-len 的比例，所以每格的碼長平均就是平均碼長
+    int root = t->root_bits;
+    uint64_t sum = 0;
+    for (int i = 0; i < (1 << root); i++) {
+        const DecodeEntry* e = &t->entries[i];
+        sum += e->sub_bits ? (uint64_t)(root + e->sub_bits) : e->length;
+    }
+    if (sum > ((uint64_t)MULTI_MAX_AVG_BITS << root)) return 0;
+    if (!t->multi_store) {
+        t->multi_store = (MultiEntry*)malloc(sizeof(MultiEntry) << MULTI_LOOKUP_BITS);
+        if (!t->multi_store) return -1;
+    }
+
+    // 每一格從頭一個碼一個碼往下解，碼要整個落在 MULTI_LOOKUP_BITS 裡才算
+    // 剩下的 bit 靠左對齊後後面補 0，前 root 個 bit 查第一層 (root <= MULTI_LOOKUP_BITS)
+    const uint32_t mask = (1u << MULTI_LOOKUP_BITS) - 1;
+    for (uint32_t i = 0; i <= mask; i++) {
+        MultiEntry m;
+        memset(&m, 0, sizeof(m));
+        int used = 0;
+        while (m.count < MULTI_MAX_SYMBOLS) {
+            uint32_t window = (i << used) & mask;
+            const DecodeEntry* e = &t->entries[window >> (MULTI_LOOKUP_BITS - root)];
+            if (e->sub_bits || e->length == 0 || e->length > MULTI_LOOKUP_BITS - used) break;
+            m.symbols[m.count++] = (uint8_t)e->symbol;
+            used += e->length;
+        }
+        m.bits = (uint8_t)used;
+        t->multi_store[i] = m;
+    }
+    t->multi = t->multi_store;
+    return 0;
+}
+
+// ==========================================
+// 4. Bit 讀取
+// ==========================================
+
+int br_init_file(BitReader* br, FILE* fp) {
+    br->fp = fp;
+    br->store = (unsigned char*)malloc(HUFF_IO_BUF + 8);
+    br->buf = br->store;
+    br->pos = br->len = 0;
+    br->acc = 0;
+    br->bitcnt = 0;
+    br->pad = 0;
+    return br->store ? 0 : -1;
+}
+
+void br_init_mem(BitReader* br, const unsigned char* data, size_t len) {
+    br->fp = NULL;
+    br->buf = data;
+    br->pos = 0;
+    br->len = len;
+    br->acc = 0;
+    br->bitcnt = 0;
+    br->pad = 0;
+    br->store = NULL;
+}
+
+void br_free(BitReader* br) {
+    free(br->store);
+    br->store = NULL;
+}
+
+int br_read_bits(BitReader* br, int n, uint32_t* v) {
+    if (br->bitcnt < n) br_refill(br);
+    *v = n ? (uint32_t)(br->acc >> (64 - n)) : 0;
+    br->acc <<= n;
+    br->bitcnt -= n;
+    return (br->pad && br_overrun(br)) ? -1 : 0;
+}
+
+// ==========================================
+// 5. Bit 寫入
+// ==========================================
+
+int bw_init(BitWriter* bw, FILE* fp) {
+    bw->fp = fp;
+    bw->buf = (unsigned char*)malloc(HUFF_OUT_BUF);
+    bw->owned = 1;
+    bw->flush_at = HUFF_OUT_BUF - 4;
+    bw->len = 0;
+    bw->acc = 0;
+    bw->bitcnt = 0;
+    bw->total = 0;
+    return bw->buf ? 0 : -1;
+}
+
+void bw_init_mem(BitWriter* bw, unsigned char* out) {
+    bw->fp = NULL;
+    bw->buf = out;
+    bw->owned = 0;
+    bw->flush_at = SIZE_MAX; // 呼叫端保證空間夠，不用 flush
+    bw->len = 0;
+    bw->acc = 0;
+    bw->bitcnt = 0;
+    bw->total = 0;
+}
+
+void bw_flush_buf(BitWriter* bw) {
+    if (!bw->fp) return;
+    if (bw->len) fwrite(bw->buf, 1, bw->len, bw->fp);
+    bw->total += bw->len;
+    bw->len = 0;
+}
+
+void bw_align(BitWriter* bw) {
+    // 剩下不滿 32 bit 的部分逐 byte 寫出，最後不足八個補 0  ex: 110 -> 110 00000
+    while (bw->bitcnt > 0) {
+        int take = bw->bitcnt >= 8 ? 8 : bw->bitcnt;
+        uint32_t byte = (uint32_t)(bw->acc >> (bw->bitcnt - take)) & ((1u << take) - 1);
+        bw->buf[bw->len++] = (unsigned char)(byte << (8 - take));
+        bw->bitcnt -= take;
+    }
+}
+
+void bw_finish(BitWriter* bw) {
+    bw_align(bw);
+    if (bw->fp) {
+        bw_flush_buf(bw);
+    }
+    else {
+        bw->total = bw->len;
+    }
+    if (bw->owned) {
+        free(bw->buf);
+        bw->buf = NULL;
+    }
+}
+
+// 拆成 code / length 兩個陣列，內層迴圈只剩查表和移位
+static inline void encode_run(BitWriter* bw, const uint32_t code[MAX_SYMBOLS], const int len[MAX_SYMBOLS],
+                              const unsigned char* in, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        bw_put(bw, code[in[i]], len[in[i]]);
+    }
+}
+
+static void split_codes(const CodeEntry codes[MAX_SYMBOLS], uint32_t code[MAX_SYMBOLS], int len[MAX_SYMBOLS]) {
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        code[i] = codes[i].code;
+        len[i] = codes[i].length;
+    }
+}
+
+uint64_t encode_bitstream(FILE* fin, FILE* fout, const CodeEntry codes[MAX_SYMBOLS]) {
+    BitWriter bw;
+    unsigned char* in = (unsigned char*)malloc(HUFF_IO_BUF);
+    if (!in || bw_init(&bw, fout) != 0) {
+        free(in);
+        return 0;
+    }
+    uint32_t code[MAX_SYMBOLS];
+    int len[MAX_SYMBOLS];
+    split_codes(codes, code, len);
+    size_t n;
+    while ((n = fread(in, 1, HUFF_IO_BUF, fin)) > 0) {
+        encode_run(&bw, code, len, in, n);
+    }
+    bw_finish(&bw);
+    free(in);
+    return bw.total;
+}
+
+size_t encode_buffer(const unsigned char* in, size_t n, const CodeEntry codes[MAX_SYMBOLS], unsigned char* out) {
+    BitWriter bw;
+    uint32_t code[MAX_SYMBOLS];
+    int len[MAX_SYMBOLS];
+    split_codes(codes, code, len);
+    bw_init_mem(&bw, out);
+    encode_run(&bw, code, len, in, n);
+    bw_finish(&bw);
+    return (size_t)bw.total;
+}
+
+size_t encode_buffer_capped(const unsigned char* in, size_t n, const CodeEntry codes[MAX_SYMBOLS], int max_len,
+                            unsigned char* out, size_t cap) {
+    BitWriter bw;
+    uint32_t code[MAX_SYMBOLS];
+    int len[MAX_SYMBOLS];
+    split_codes(codes, code, len);
+    bw_init_mem(&bw, out);
+    for (size_t i = 0; i < n; i += ENCODE_CAP_CHUNK) {
+        size_t m = n - i < ENCODE_CAP_CHUNK ? n - i : ENCODE_CAP_CHUNK;
+        // acc 裡還沒寫出的 bit 加 bw_finish 的補齊最多 8 byte
+        if (bw.len + (m * (size_t)max_len + 7) / 8 + 8 > cap) return 0;
+        encode_run(&bw, code, len, in + i, m);
+    }
+    bw_finish(&bw);
+    return (size_t)bw.total;
+}
+
+// ==========================================
+// 6. 查表解碼
+// ==========================================
+
+// 一次一個符號：解出最多 n 個符號到 out，回傳實際解出的數量 (遇到壞碼或資料截斷時會少於 n)
+static size_t decode_run_single(BitReader* br, const DecodeTable* t, unsigned char* out, size_t n) {
+    const DecodeEntry* entries = t->entries;
+    const int root = t->root_bits;
+    // 每次補滿 acc 後最多能連續解幾個符號
+    int per_refill = 56 / t->max_len;
+    if (per_refill > 4) per_refill = 4;
+    size_t done = 0;
+
+    while (done < n) {
+        br_refill(br);
+        for (int k = 0; k < per_refill && done < n; k++) {
+            DecodeEntry e = entries[br->acc >> (64 - root)];
+            if (e.sub_bits) {
+                uint32_t idx = (uint32_t)(br->acc << root >> (64 - e.sub_bits));
+                e = entries[t->sub_base[e.symbol] + idx];
+            }
+            if (e.length == 0) { // 不存在的碼
+                return done;
+            }
+            br->acc <<= e.length;
+            br->bitcnt -= e.length;
+            if (br->pad && br_overrun(br)) { // 吃到結尾補上的 0：資料被截斷
+                return done;
+            }
+            out[done++] = (unsigned char)e.symbol;
+        }
+    }
+    return done;
+}
+
+// 多符號表查一次：固定寫 MULTI_MAX_SYMBOLS 個 byte (呼叫端保證後面放得下)，done 前進 count 個
+// 第一個碼太長時用一般的表解一個，解完補滿 acc，這一輪後面的查表還是有足夠的 bit
+#define DECODE_MULTI(br, dst, done, fail)                                           \
+    do {                                                                            \
+        MultiEntry m = multi[(br).acc >> (64 - MULTI_LOOKUP_BITS)];                 \
+        if (m.count) {                                                              \
+            memcpy((dst) + (done), m.symbols, MULTI_MAX_SYMBOLS);                   \
+            (done) += m.count;                                                      \
+            (br).acc <<= m.bits;                                                    \
+            (br).bitcnt -= m.bits;                                                  \
+        }                                                                           \
+        else {                                                                      \
+            if (decode_run_single(&(br), t, (dst) + (done), 1) != 1) fail;          \
+            (done)++;                                                               \
+            br_refill(&(br));                                                       \
+        }                                                                           \
+    } while (0)
+
+// 一輪 (補滿一次 acc) 最多解出幾個符號
+#define MULTI_ROUND (MULTI_PER_REFILL * MULTI_MAX_SYMBOLS)
+
+// 多符號版：離結尾還有一輪以上時才查多符號表，這樣解出的一定都是真的符號，不會吃到結尾補的 0
+static size_t decode_run_multi(BitReader* br, const DecodeTable* t, unsigned char* out, size_t n) {
+    const MultiEntry* multi = t->multi;
+    size_t done = 0;
+    while (n - done > MULTI_ROUND) {
+        br_refill(br);
+        for (int k = 0; k < MULTI_PER_REFILL; k++) DECODE_MULTI(*br, out, done, return done);
+        if (br->pad && br_overrun(br)) return done;
+    }
+    return done + decode_run_single(br, t, out + done, n - done);
+}
+
+static size_t decode_run(BitReader* br, const DecodeTable* t, unsigned char* out, size_t n) {
+    return t->multi ? decode_run_multi(br, t, out, n) : decode_run_single(br, t, out, n);
+}
+
+int br_decode_symbol(BitReader* br, const DecodeTable* t) {
+    if (t->max_len == 0) return -1;
+    if (br->bitcnt < t->max_len) br_refill(br);
+    DecodeEntry e = t->entries[br->acc >> (64 - t->root_bits)];
+    if (e.sub_bits) {
+        uint32_t idx = (uint32_t)(br->acc << t->root_bits >> (64 - e.sub_bits));
+        e = t->entries[t->sub_base[e.symbol] + idx];
+    }
+    if (e.length == 0) return -1;
+    br->acc <<= e.length;
+    br->bitcnt -= e.length;
+    if (br->pad && br_overrun(br)) return -1;
+    return e.symbol;
+}
+
+size_t br_decode_bytes(BitReader* br, const DecodeTable* t, unsigned char* out, size_t n) {
+    if (t->max_len == 0) return 0;
+    return decode_run(br, t, out, n);
+}
+
+uint64_t decode_bitstream(FILE* fin, FILE* fout, const DecodeTable* t, uint64_t original_size) {
+    uint64_t remain = original_size;
+    if (remain == 0) return 0;
+    if (t->max_len == 0) return remain;
+
+    BitReader br;
+    unsigned char* out = (unsigned char*)malloc(HUFF_IO_BUF);
+    if (br_init_file(&br, fin) != 0 || !out) {
+        br_free(&br);
+        free(out);
+        return remain;
+    }
+
+    while (remain > 0) {
+        size_t want = remain < HUFF_IO_BUF ? (size_t)remain : HUFF_IO_BUF;
+        size_t got = decode_run(&br, t, out, want);
+        fwrite(out, 1, got, fout);
+        remain -= got;
+        if (got < want) break;
+    }
+    free(out);
+    br_free(&br);
+    return remain;
+}
+
+int decode_buffer(const unsigned char* in, size_t in_len, const DecodeTable* t, unsigned char* out, size_t n) {
+    if (n == 0) return 0;
+    if (t->max_len == 0) return -1;
+    BitReader br;
+    br_init_mem(&br, in, in_len);
+    return decode_run(&br, t, out, n) == n ? 0 : -1;
+}
+
+int decode_buffer_ctx(const unsigned char* in, size_t in_len, const DecodeTable* const ctx[MAX_SYMBOLS],
+                      unsigned char* out, size_t n) {
+    int max_len = 0;
+    for (int c = 0; c < MAX_SYMBOLS; c++) {
+        if (ctx[c]->max_len > max_len) max_len = ctx[c]->max_len;
+    }
+    if (n == 0) return 0;
+    if (max_len == 0) return -1;
+    int per_refill = 56 / max_len;
+    if (per_refill > 4) per_refill = 4;
+
+    BitReader br;
+    br_init_mem(&br, in, in_len);
+    unsigned prev = 0;
+    size_t done = 0;
+    while (done < n) {
+        br_refill(&br);
+        for (int k = 0; k < per_refill && done < n; k++) {
+            const DecodeTable* t = ctx[prev];
+            if (t->max_len == 0) return -1;   // 這個 context 沒有表 (編碼端不會用到)
+            DecodeEntry e = t->entries[br.acc >> (64 - t->root_bits)];
+            if (e.sub_bits) {
+                uint32_t idx = (uint32_t)(br.acc << t->root_bits >> (64 - e.sub_bits));
+                e = t->entries[t->sub_base[e.symbol] + idx];
+            }
+            if (e.length == 0) return -1;
+            br.acc <<= e.length;
+            br.bitcnt -= e.length;
+            prev = e.symbol;
+            out[done++] = (unsigned char)prev;
+        }
+        if (br.pad && br_overrun(&br)) return -1;
+    }
+    return 0;
+}
+
+// ==========================================
+// 7. 4 條 bitstream 交錯解碼
+// ==========================================
+
+void stream4_split(size_t n, size_t seg[4]) {
+    size_t q = (n + 3) / 4;
+    for (int s = 0; s < 4; s++) {
+        size_t start = q * (size_t)s;
+        seg[s] = start >= n ? 0 : (n - start < q ? n - start : q);
+    }
+}
+
+// 單一符號的查表 (不做截斷檢查，由呼叫端每輪檢查一次)
+#define DECODE_ONE(br, dst)                                                    \
+    do {                                                                       \
+        DecodeEntry e = entries[(br).acc >> (64 - root)];                      \
+        if (e.sub_bits) {                                                      \
+            uint32_t idx = (uint32_t)((br).acc << root >> (64 - e.sub_bits));  \
+            e = entries[t->sub_base[e.symbol] + idx];                          \
+        }                                                                      \
+        if (e.length == 0) return -1;                                          \
+        (br).acc <<= e.length;                                                 \
+        (br).bitcnt -= e.length;                                               \
+        (dst) = (unsigned char)e.symbol;                                       \
+    } while (0)
+
+int decode_buffer4(const unsigned char* const in[4], const size_t in_len[4], const DecodeTable* t,
+                   unsigned char* out, size_t n) {
+    if (n == 0) return 0;
+    if (t->max_len == 0) return -1;
+
+    const DecodeEntry* entries = t->entries;
+    const int root = t->root_bits;
+    int per_refill = 56 / t->max_len;
+    if (per_refill > 4) per_refill = 4;
+
+    size_t seg[4];
+    stream4_split(n, seg);
+    BitReader br[4];
+    unsigned char* o[4];
+    for (int s = 0; s < 4; s++) {
+        br_init_mem(&br[s], in[s], in_len[s]);
+        o[s] = out + (n + 3) / 4 * (size_t)s;
+    }
+
+    if (t->multi) {
+        // 多符號表：每條 stream 一次解出的數量不一樣，各自記進度
+        const MultiEntry* multi = t->multi;
+        size_t d[4] = { 0, 0, 0, 0 };
+        while (seg[0] - d[0] > MULTI_ROUND && seg[1] - d[1] > MULTI_ROUND &&
+               seg[2] - d[2] > MULTI_ROUND && seg[3] - d[3] > MULTI_ROUND) {
+            br_refill(&br[0]);
+            br_refill(&br[1]);
+            br_refill(&br[2]);
+            br_refill(&br[3]);
+            for (int k = 0; k < MULTI_PER_REFILL; k++) {
+                DECODE_MULTI(br[0], o[0], d[0], return -1);
+                DECODE_MULTI(br[1], o[1], d[1], return -1);
+                DECODE_MULTI(br[2], o[2], d[2], return -1);
+                DECODE_MULTI(br[3], o[3], d[3], return -1);
+            }
+            for (int s = 0; s < 4; s++) {
+                if (br[s].pad && br_overrun(&br[s])) return -1;
+            }
+        }
+        for (int s = 0; s < 4; s++) {
+            size_t rest = seg[s] - d[s];
+            if (rest > 0 && decode_run(&br[s], t, o[s] + d[s], rest) != rest) return -1;
+        }
+        return 0;
+    }
+
+    // 四段都還夠長時，一次補滿四個累加器，再輪流各解 per_refill 個
+    // 相鄰的查表屬於不同 stream，CPU 可以同時進行
+    size_t done = 0;
+    while (done + (size_t)per_refill <= seg[3]) {
+        br_refill(&br[0]);
+        br_refill(&br[1]);
+        br_refill(&br[2]);
+        br_refill(&br[3]);
+        for (int k = 0; k < per_refill; k++) {
+            DECODE_ONE(br[0], o[0][done + k]);
+            DECODE_ONE(br[1], o[1][done + k]);
+            DECODE_ONE(br[2], o[2][done + k]);
+            DECODE_ONE(br[3], o[3][done + k]);
+        }
+        for (int s = 0; s < 4; s++) {
+            if (br[s].pad && br_overrun(&br[s])) return -1;
+        }
+        done += (size_t)per_refill;
+    }
+
+    // 剩下的尾巴一條一條解
+    for (int s = 0; s < 4; s++) {
+        size_t rest = seg[s] - done;
+        if (rest > 0 && decode_run(&br[s], t, o[s] + done, rest) != rest) return -1;
+    }
+    return 0;
+}
+
+// ==========================================
+// 8. 變長整數 / 碼長表
+// ==========================================
+
+size_t put_varint(unsigned char* p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+int get_varint(const unsigned char* p, size_t avail, uint64_t* v) {
+    uint64_t r = 0;
+    for (size_t i = 0; i < avail && i < VARINT_MAX; i++) {
+        r |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) {
+            *v = r;
+            return (int)i + 1;
+        }
+    }
+    return -1;
+}
+
+int read_varint(FILE* fp, uint64_t* v) {
+    unsigned char buf[VARINT_MAX];
+    for (int i = 0; i < VARINT_MAX; i++) {
+        int c = fgetc(fp);
+        if (c == EOF) return -1;
+        buf[i] = (unsigned char)c;
+        if (!(c & 0x80)) return get_varint(buf, (size_t)i + 1, v);
+    }
+    return -1;
+}
+
+// 碼長碼的長度照這個順序送，最常是 0 的排後面，尾巴的 0 就可以不送
+static const uint8_t cl_order[CL_SYMBOLS] = {
+    CL_ZERO_SHORT, CL_ZERO_LONG, CL_REPEAT, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+};
+
+static const int cl_extra_bits[3] = { 2, 3, 7 };   // CL_REPEAT, CL_ZERO_SHORT, CL_ZERO_LONG
+static const int cl_extra_base[3] = { 3, 3, 11 };
+
+// run-length 之後的一項：碼長碼的符號 + 附加值
+typedef struct {
+    uint8_t sym;
+    uint8_t extra;
+} ClItem;
+
+static int run_length_lengths(const int lengths[MAX_SYMBOLS], ClItem items[MAX_SYMBOLS]) {
+    int m = 0;
+    for (int i = 0; i < MAX_SYMBOLS;) {
+        int len = lengths[i];
+        int run = 1;
+        while (i + run < MAX_SYMBOLS && lengths[i + run] == len) run++;
+        i += run;
+        if (len == 0) {
+            while (run >= 11) {
+                int take = run < 138 ? run : 138;
+                items[m].sym = CL_ZERO_LONG;
+                items[m++].extra = (uint8_t)(take - 11);
+                run -= take;
+            }
+            if (run >= 3) {
+                items[m].sym = CL_ZERO_SHORT;
+                items[m++].extra = (uint8_t)(run - 3);
+                run = 0;
+            }
+        }
+        else {
+            // 先送一次長度本身，後面的用「重複前一個」
+            items[m].sym = (uint8_t)len;
+            items[m++].extra = 0;
+            run--;
+            while (run >= 3) {
+                int take = run < 6 ? run : 6;
+                items[m].sym = CL_REPEAT;
+                items[m++].extra = (uint8_t)(take - 3);
+                run -= take;
+            }
+        }
+        while (run-- > 0) {
+            items[m].sym = (uint8_t)len;
+            items[m++].extra = 0;
+        }
+    }
+    return m;
+}
+
+size_t put_length_table(const int lengths[MAX_SYMBOLS], unsigned char* out) {
+    ClItem items[MAX_SYMBOLS];
+    int m = run_length_lengths(lengths, items);
+
+    // 碼長序列本身的頻率 → 碼長碼 (最長 CL_MAX_BITS)
+    int freq[MAX_SYMBOLS] = {0};
+    int cl_len[MAX_SYMBOLS] = {0};
+    for (int i = 0; i < m; i++) freq[items[i].sym]++;
+    build_code_lengths(freq, cl_len);
+    for (int s = 0; s < CL_SYMBOLS; s++) {
+        if (cl_len[s] > CL_MAX_BITS) {
+            limit_code_lengths(freq, cl_len, CL_MAX_BITS);
+            break;
+        }
+    }
+    CodeEntry codes[MAX_SYMBOLS];
+    generate_limited_codes(cl_len, codes);
+
+    int hclen = CL_SYMBOLS;
+    while (hclen > 4 && cl_len[cl_order[hclen - 1]] == 0) hclen--;
+
+    BitWriter bw;
+    bw_init_mem(&bw, out);
+    bw_put(&bw, (uint32_t)(hclen - 4), 6);
+    for (int i = 0; i < hclen; i++) bw_put(&bw, (uint32_t)cl_len[cl_order[i]], 3);
+    for (int i = 0; i < m; i++) {
+        int s = items[i].sym;
+        bw_put(&bw, codes[s].code, codes[s].length);
+        if (s >= CL_REPEAT) bw_put(&bw, items[i].extra, cl_extra_bits[s - CL_REPEAT]);
+    }
+    bw_finish(&bw);
+    return (size_t)bw.total;
+}
+
+int get_length_table(const unsigned char* in, size_t avail, int lengths[MAX_SYMBOLS]) {
+    BitReader br;
+    uint32_t v;
+    br_init_mem(&br, in, avail);
+
+    int cl_len[MAX_SYMBOLS] = {0};
+    if (br_read_bits(&br, 6, &v) != 0 || v + 4 > CL_SYMBOLS) return -1;
+    int hclen = (int)v + 4;
+    for (int i = 0; i < hclen; i++) {
+        if (br_read_bits(&br, 3, &v) != 0) return -1;
+        cl_len[cl_order[i]] = (int)v;
+    }
+    DecodeTable dt;
+    if (build_decode_table(&dt, cl_len) != 0) return -1;
+
+    int n = 0;
+    int rc = 0;
+    while (n < MAX_SYMBOLS) {
+        int s = br_decode_symbol(&br, &dt);
+        if (s < 0) {
+            rc = -1;
+            break;
+        }
+        if (s < CL_REPEAT) {
+            lengths[n++] = s;
+            continue;
+        }
+        // 重複符號：附加值決定次數，不能超出 256 個
+        if (br_read_bits(&br, cl_extra_bits[s - CL_REPEAT], &v) != 0) {
+            rc = -1;
+            break;
+        }
+        int count = (int)v + cl_extra_base[s - CL_REPEAT];
+        if ((s == CL_REPEAT && n == 0) || n + count > MAX_SYMBOLS) {
+            rc = -1;
+            break;
+        }
+        int fill = (s == CL_REPEAT) ? lengths[n - 1] : 0;
+        while (count-- > 0) lengths[n++] = fill;
+    }
+    free_decode_table(&dt);
+    if (rc != 0) return -1;
+
+    // 用掉的 bit 數 (補進來的 0 不算)，湊成整個 byte
+    uint64_t bits = (uint64_t)(br.pos + br.pad) * 8 - (uint64_t)br.bitcnt;
+    return (int)((bits + 7) / 8);
+}
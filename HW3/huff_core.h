@@ -0,0 +1,260 @@
+// huff_core.h - HW3 三個版本 (main.c / huffman.c / huffman_two_mode.c) 共用的 Huffman 核心
+#ifndef HUFF_CORE_H
+#define HUFF_CORE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define MAX_SYMBOLS 256
+#define MAX_CODE_LEN 256
+
+// ==========================================
+// 解碼參數
+// ==========================================
+#define HUFF_MAX_BITS    32         // 解碼器能處理的最長碼長
+#define HUFF_LOOKUP_BITS 11         // 第一層查表一次看幾個 bit
+#define MULTI_LOOKUP_BITS  HUFF_LOOKUP_BITS            // 多符號表一次看幾個 bit
+#define MULTI_MAX_SYMBOLS  4                           // 多符號表一格最多幾個符號
+#define MULTI_PER_REFILL   (56 / MULTI_LOOKUP_BITS)    // 補滿 acc 一次可以查幾次
+#define MULTI_MAX_AVG_BITS 6                           // 平均碼長不超過這個才建多符號表
+#define HUFF_IO_BUF      (1 << 16)  // 讀寫緩衝區大小
+#define HUFF_OUT_BUF     (1 << 20)  // 編碼輸出緩衝區大小
+#define SAMPLE_CHUNK     256        // 抽樣統計時每次連續數幾個 byte
+#define ENCODE_CAP_CHUNK 4096       // encode_buffer_capped 每段編幾個 byte 檢查一次空間
+
+// ==========================================
+// 碼長表格式 (和 DEFLATE 的 code-length code 同一個想法)
+// ==========================================
+// 256 個碼長先做 run-length，變成 0..32 的長度和 3 種重複符號，再用一組 Huffman 碼 (最長 7 bit) 寫出
+//   6 bit  : 送了幾個碼長碼的長度 - 4 (依 cl_order 的順序，後面沒送的都是 0)
+//   3 bit × 上面的個數 : 碼長碼的長度
+//   之後是碼長序列，結尾補 0 到整個 byte
+#define CL_REPEAT     33   // 重複前一個長度 3-6 次 (後面 2 bit)
+#define CL_ZERO_SHORT 34   // 3-10 個 0 (後面 3 bit)
+#define CL_ZERO_LONG  35   // 11-138 個 0 (後面 7 bit)
+#define CL_SYMBOLS    36
+#define CL_MAX_BITS   7
+#define LENGTH_TABLE_MAX ((6 + CL_SYMBOLS * 3 + MAX_SYMBOLS * CL_MAX_BITS + 7) / 8)
+#define VARINT_MAX    10
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+// 建立碼表
+typedef struct {
+    unsigned int code;
+    unsigned char length;
+    unsigned char symbol;
+} CodeEntry;
+
+// 查表解碼的一格
+// sub_bits == 0 : symbol / length 就是答案 (length == 0 代表不合法的碼)
+// sub_bits  > 0 : 碼比第一層長，symbol 是第二層子表的編號
+typedef struct {
+    uint16_t symbol;
+    uint8_t  length;   // 整個碼的長度 (會吃掉幾個 bit)
+    uint8_t  sub_bits; // 第二層子表的位元數
+} DecodeEntry;
+
+// 多符號表的一格：接下來 MULTI_LOOKUP_BITS 個 bit 裡完整的碼 (最多 MULTI_MAX_SYMBOLS 個) 一次解出來
+// count == 0 : 第一個碼就比 MULTI_LOOKUP_BITS 長 (或不存在)，要走一般的兩層表
+typedef struct {
+    uint8_t symbols[MULTI_MAX_SYMBOLS];
+    uint8_t count;
+    uint8_t bits;      // count 個碼總共幾個 bit
+    uint8_t unused[2];
+} MultiEntry;
+
+// 兩層查表解碼器
+typedef struct {
+    int root_bits;          // 第一層位元數 (<= HUFF_LOOKUP_BITS)
+    int max_len;            // 最長碼長
+    DecodeEntry* entries;   // 第一層 (1 << root_bits 格) 後面接所有子表
+    uint32_t* sub_base;     // 每個子表在 entries 裡的起點
+    int num_entries;
+    int num_subs;
+    int cap_entries;        // entries / sub_base 已配置的大小，重建時夠用就不重新配置
+    int cap_subs;
+    MultiEntry* multi;        // 多符號表 (build_multi_table 選用時才有)，NULL = 一次解一個
+    MultiEntry* multi_store;  // multi 的空間，重建時沿用
+} DecodeTable;
+
+// 讀 bit 的緩衝區 (MSB first，和 compress_file_bin 寫出的順序相同)
+// fp 不是 NULL 時從檔案分段讀進 store；否則直接讀呼叫端給的記憶體
+typedef struct {
+    FILE* fp;
+    const unsigned char* buf;
+    size_t pos, len;
+    uint64_t acc;      // 有效 bit 靠左放
+    int bitcnt;        // acc 裡有效的 bit 數
+    size_t pad;        // 讀到結尾後補了幾個 0 byte
+    unsigned char* store; // 讀檔時才配置 (HUFF_IO_BUF + 8)，讀記憶體時是 NULL
+} BitReader;
+
+// 64-bit 累加器的 bit 寫入器：湊滿 32 bit 才整個 word 寫進輸出緩衝區
+// fp 是 NULL 時直接寫進呼叫端的記憶體 (空間由呼叫端保證)
+typedef struct {
+    FILE* fp;
+    unsigned char* buf;
+    int owned;         // buf 是不是自己 malloc 的
+    size_t len;
+    size_t flush_at;   // len 超過這個值就寫出
+    uint64_t acc;      // 有效 bit 靠右放
+    int bitcnt;        // acc 裡有效的 bit 數 (< 32)
+    uint64_t total;    // 已經寫出的 byte 數
+} BitWriter;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 統計 buf 裡每個 byte 出現的次數 (累加到 freq)；n 要小於 4 GiB */
+void count_block_frequency(const unsigned char* buf, size_t n, int freq[MAX_SYMBOLS]);
+
+/* 抽樣統計：每 stride 段 SAMPLE_CHUNK byte 只數第一段，累加到 freq，回傳數了幾個 byte
+   樣本沒看到的 byte 要不要補、怎麼補由呼叫端決定 */
+size_t sample_block_frequency(const unsigned char* buf, size_t n, int stride, int freq[MAX_SYMBOLS]);
+
+/* 由頻率直接算出 Huffman 碼長 (不建樹、不配置記憶體)；回傳出現過的符號數
+   只有一個符號時給它長度 1，確保解碼端有碼可查 */
+int build_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS]);
+
+/* Package-merge：在最長不超過 limit 的條件下求最佳碼長
+   limit 太小 (符號數 > 2^limit) 回傳 -1 */
+int limit_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS], int limit);
+
+/* 依 canonical 規則由 lengths 算出每個符號的整數碼值 (table 以符號為索引) */
+void generate_limited_codes(const int lengths[MAX_SYMBOLS], CodeEntry table[MAX_SYMBOLS]);
+
+/* 把整數碼值轉成 '0'/'1' 字串 (只給印表用) */
+void code_to_string(unsigned int code, int length, char* out);
+
+/* 由 lengths 建立兩層查表解碼器；碼長不合法 (超過 HUFF_MAX_BITS 或違反 Kraft) 回傳負值 */
+int build_decode_table(DecodeTable* t, const int lengths[MAX_SYMBOLS]);
+/* 同上，但沿用 t 之前配置的空間 (t 要先 build 過或是全部清成 0) */
+int rebuild_decode_table(DecodeTable* t, const int lengths[MAX_SYMBOLS]);
+void free_decode_table(DecodeTable* t);
+/* 平均碼長不超過 MULTI_MAX_AVG_BITS 時，在 t 上多建一張多符號表，之後的解碼一次查表解出好幾個符號
+   碼長比較長的表不建 (一格大概只放得下一個碼，沒有好處)；配置失敗回傳 -1 (t 還是可以照常用) */
+int  build_multi_table(DecodeTable* t);
+
+/* 從 fin 目前位置開始解 bitstream，寫出 original_size 個 byte
+   回傳還沒解出來的 byte 數 (0 代表成功) */
+uint64_t decode_bitstream(FILE* fin, FILE* fout, const DecodeTable* t, uint64_t original_size);
+
+/* Bit 讀取 */
+int  br_init_file(BitReader* br, FILE* fp);   // 配置不到緩衝區回傳 -1
+void br_init_mem(BitReader* br, const unsigned char* data, size_t len);
+void br_free(BitReader* br);
+/* 讀 n 個 bit (n <= 32) 到 *v；讀過資料結尾回傳 -1 */
+int  br_read_bits(BitReader* br, int n, uint32_t* v);
+
+/* 把 acc 補到至少 56 個有效 bit (放在標頭檔裡，其他模組自己的解碼迴圈也能 inline 進去) */
+static inline void br_refill(BitReader* br) {
+    if (br->len - br->pos < 8) {
+        if (br->fp) {
+            // 緩衝區快用完：把剩下的搬到前面再讀
+            size_t rest = br->len - br->pos;
+            memmove(br->store, br->buf + br->pos, rest);
+            br->pos = 0;
+            br->len = rest + fread(br->store + rest, 1, HUFF_IO_BUF - rest, br->fp);
+        }
+        if (br->len - br->pos < 8) {
+            // 真的到結尾：一次補一個 byte，不夠的補 0
+            while (br->bitcnt <= 56) {
+                uint64_t byte = 0;
+                if (br->pos < br->len) byte = br->buf[br->pos++];
+                else br->pad++;
+                br->acc |= byte << (56 - br->bitcnt);
+                br->bitcnt += 8;
+            }
+            return;
+        }
+    }
+    // 一次載入 8 byte (big-endian)，只前進真的放進 acc 的 byte 數
+    const unsigned char* p = br->buf + br->pos;
+    uint64_t w = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+                 ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+                 ((uint64_t)p[6] << 8)  |  (uint64_t)p[7];
+    br->acc |= w >> br->bitcnt;
+    br->pos += (size_t)(63 - br->bitcnt) >> 3;
+    br->bitcnt |= 56;
+}
+
+/* 讀進來的 0 是不是已經被吃掉 (代表資料被截斷) */
+static inline int br_overrun(const BitReader* br) {
+    return (uint64_t)br->pad * 8 > (uint64_t)br->bitcnt;
+}
+
+/* 從記憶體解出 n 個 byte；資料壞掉或不夠時回傳 -1 */
+int decode_buffer(const unsigned char* in, size_t in_len, const DecodeTable* t, unsigned char* out, size_t n);
+
+/* order-1 版：每個 byte 用 ctx[前一個 byte] 那張表解 (第一個 byte 的前一個當作 0)
+   資料壞掉或不夠時回傳 -1 */
+int decode_buffer_ctx(const unsigned char* in, size_t in_len, const DecodeTable* const ctx[MAX_SYMBOLS],
+                      unsigned char* out, size_t n);
+
+/* 查表解一個符號 (不限定是 byte)；碼不存在或讀過結尾回傳 -1 */
+int br_decode_symbol(BitReader* br, const DecodeTable* t);
+
+/* 從 br 接著解出最多 n 個 byte (可以分很多次呼叫)，回傳實際解出的數量；少於 n 代表資料壞掉或被截斷 */
+size_t br_decode_bytes(BitReader* br, const DecodeTable* t, unsigned char* out, size_t n);
+
+/* 4 條 bitstream 版：out 切成 4 段 (見 stream4_split)，第 s 段從 in[s] 解
+   四個讀取器在同一個迴圈裡輪流前進，彼此沒有相依；資料壞掉或不夠時回傳 -1 */
+int decode_buffer4(const unsigned char* const in[4], const size_t in_len[4], const DecodeTable* t,
+                   unsigned char* out, size_t n);
+
+/* n 個 byte 切成 4 段時每段的長度 (前 3 段一樣長，最後一段可能比較短) */
+void stream4_split(size_t n, size_t seg[4]);
+
+/* Bit 寫入 */
+int  bw_init(BitWriter* bw, FILE* fp);
+void bw_init_mem(BitWriter* bw, unsigned char* out);
+void bw_flush_buf(BitWriter* bw);
+void bw_align(BitWriter* bw);    // acc 裡剩下的 bit 補 0 到整個 byte，放進輸出緩衝區 (還沒寫出)
+void bw_finish(BitWriter* bw);   // 補 0 到整個 byte、全部寫出並釋放緩衝區
+
+/* 寫入 len 個 bit (len <= HUFF_MAX_BITS) */
+static inline void bw_put(BitWriter* bw, uint32_t code, int len) {
+    bw->acc = (bw->acc << len) | code;
+    bw->bitcnt += len;
+    if (bw->bitcnt >= 32) {
+        uint32_t w = (uint32_t)(bw->acc >> (bw->bitcnt - 32));
+        unsigned char* p = bw->buf + bw->len;
+        p[0] = (unsigned char)(w >> 24);
+        p[1] = (unsigned char)(w >> 16);
+        p[2] = (unsigned char)(w >> 8);
+        p[3] = (unsigned char)w;
+        bw->len += 4;
+        bw->bitcnt -= 32;
+        if (bw->len > bw->flush_at) bw_flush_buf(bw);
+    }
+}
+
+/* 從 fin 目前位置讀到檔尾，用 codes 編成 bitstream 寫到 fout；回傳寫出的 byte 數 */
+uint64_t encode_bitstream(FILE* fin, FILE* fout, const CodeEntry codes[MAX_SYMBOLS]);
+
+/* 把記憶體裡的 n 個 byte 編碼到 out；回傳寫出的 byte 數
+   out 至少要有 (n * 最長碼長 + 7) / 8 + 8 byte */
+size_t encode_buffer(const unsigned char* in, size_t n, const CodeEntry codes[MAX_SYMBOLS], unsigned char* out);
+
+/* 同上，但 out 只有 cap byte：一段一段編，最壞情況 (每個都是 max_len 的碼) 可能寫不下時就停，回傳 0 (n 要 > 0) */
+size_t encode_buffer_capped(const unsigned char* in, size_t n, const CodeEntry codes[MAX_SYMBOLS], int max_len,
+                            unsigned char* out, size_t cap);
+
+/* 小工具：7 bit 一組的變長整數 (LEB128)，小的數字只要 1 byte */
+size_t put_varint(unsigned char* p, uint64_t v);
+int    get_varint(const unsigned char* p, size_t avail, uint64_t* v);   // 回傳用掉的 byte 數，失敗 -1
+int    read_varint(FILE* fp, uint64_t* v);                                // 從檔案讀，失敗 -1
+
+/* 把 256 個碼長壓成碼長表寫到 out (最多 LENGTH_TABLE_MAX byte)，回傳 byte 數 */
+size_t put_length_table(const int lengths[MAX_SYMBOLS], unsigned char* out);
+
+/* 從 in 讀回 256 個碼長；回傳用掉的 byte 數，資料不夠或格式不對回傳 -1 */
+int    get_length_table(const unsigned char* in, size_t avail, int lengths[MAX_SYMBOLS]);
+
+#endif // HUFF_CORE_H
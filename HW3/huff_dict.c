@@ -0,0 +1,111 @@
+#include <string.h>
+#include "huff_dict.h"
+
+// ==========================================
+// 1. 建立 / 載入
+// ==========================================
+
+// 碼長的 FNV-1a hash，0 保留不用
+static uint32_t dict_hash(const int lengths[MAX_SYMBOLS]) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        h ^= (uint32_t)lengths[i];
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+// 碼長定了之後：算 ID、產生碼、建解碼表
+static int dict_finish(HuffDict* d) {
+    d->max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (d->lengths[i] > d->max_len) d->max_len = d->lengths[i];
+    }
+    d->id = dict_hash(d->lengths);
+    generate_limited_codes(d->lengths, d->codes);
+    return build_decode_table(&d->dt, d->lengths) == 0 ? 0 : -1;
+}
+
+int dict_train(const uint64_t freq[MAX_SYMBOLS], int limit_L, HuffDict* d) {
+    memset(d, 0, sizeof(*d));
+    // 樣本很大時先等比例縮小到 int 放得下；每個 byte 都加 1，沒看過的也有碼
+    uint64_t total = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) total += freq[i];
+    int shift = 0;
+    while ((total >> shift) > (1u << 30)) shift++;
+    int f[MAX_SYMBOLS];
+    for (int i = 0; i < MAX_SYMBOLS; i++) f[i] = (int)(freq[i] >> shift) + 1;
+
+    build_code_lengths(f, d->lengths);
+    int limit = (limit_L <= 0 || limit_L > HUFF_MAX_BITS) ? HUFF_MAX_BITS : limit_L;
+    int max_len = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (d->lengths[i] > max_len) max_len = d->lengths[i];
+    }
+    if (max_len > limit && limit_code_lengths(f, d->lengths, limit) != 0) return -1;
+    return dict_finish(d);
+}
+
+size_t dict_save(const HuffDict* d, unsigned char* out) {
+    memcpy(out, DICT_MAGIC, 4);
+    out[4] = DICT_VERSION;
+    for (int i = 0; i < 4; i++) out[5 + i] = (unsigned char)(d->id >> (8 * i));
+    return 9 + put_length_table(d->lengths, out + 9);
+}
+
+int dict_load(const unsigned char* in, size_t n, HuffDict* d) {
+    memset(d, 0, sizeof(*d));
+    if (n < 9 || memcmp(in, DICT_MAGIC, 4) != 0 || in[4] != DICT_VERSION) return -1;
+    uint32_t id = (uint32_t)in[5] | ((uint32_t)in[6] << 8) | ((uint32_t)in[7] << 16) | ((uint32_t)in[8] << 24);
+    if (get_length_table(in + 9, n - 9, d->lengths) < 0) return -1;
+    // 每個 byte 都要有碼，不然有些訊息編不出來
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (d->lengths[i] == 0) return -1;
+    }
+    if (dict_finish(d) != 0 || d->id != id) {
+        dict_free(d);
+        return -1;
+    }
+    return 0;
+}
+
+void dict_free(HuffDict* d) {
+    free_decode_table(&d->dt);
+}
+
+// ==========================================
+// 2. 壓縮 / 解壓縮一則訊息
+// ==========================================
+
+size_t dict_bound(const HuffDict* d, size_t n) {
+    return DICT_HEADER_MAX + (n * (size_t)d->max_len + 7) / 8 + 8;
+}
+
+size_t dict_compress(const HuffDict* d, const unsigned char* in, size_t n, unsigned char* out) {
+    for (int i = 0; i < 4; i++) out[i] = (unsigned char)(d->id >> (8 * i));
+    size_t head = 4 + put_varint(out + 4, n);
+    return head + encode_buffer(in, n, d->codes, out + head);
+}
+
+// 檢查 ID 並讀出原始大小，回傳 bitstream 的起點
+static int read_message_header(const HuffDict* d, const unsigned char* in, size_t len, uint64_t* size) {
+    if (len < 5) return -1;
+    uint32_t id = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    if (id != d->id) return -1;
+    int k = get_varint(in + 4, len - 4, size);
+    return k < 0 ? -1 : 4 + k;
+}
+
+int dict_get_size(const HuffDict* d, const unsigned char* in, size_t len, uint64_t* size) {
+    return read_message_header(d, in, len, size) < 0 ? -1 : 0;
+}
+
+int dict_decompress(const HuffDict* d, const unsigned char* in, size_t len, unsigned char* out, size_t cap,
+                    size_t* out_len) {
+    uint64_t size;
+    int head = read_message_header(d, in, len, &size);
+    if (head < 0) return -1;
+    if (size > cap) return -2;
+    *out_len = (size_t)size;
+    return decode_buffer(in + head, len - (size_t)head, &d->dt, out, (size_t)size) == 0 ? 0 : -1;
+}
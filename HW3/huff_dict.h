@@ -0,0 +1,64 @@
+// huff_dict.h - 預先訓練好的碼表 (字典)：給大量很小的訊息共用
+//
+// 幾百 byte 的訊息，每次統計頻率、寫碼長表反而比省下來的還多
+// 先從一批樣本統計頻率算出一張碼表存成字典檔，壓縮時直接拿來用：不統計、不建表，只寫字典 ID + bitstream
+// 樣本裡沒出現過的 byte 也給一個碼 (頻率當作至少 1)，任何訊息都編得出來
+// 字典載入時就把碼和解碼表都建好，之後每則訊息只剩編碼 / 查表解碼
+//
+// 字典檔    : "HUFD" | version | dict_id (4) | 碼長表 (見 huff_core.h)
+// 壓縮訊息  : dict_id (4) | 原始大小 (varint) | bitstream
+// dict_id 是碼長的 hash，同樣的碼表一定得到同一個 ID；解壓時 ID 對不上就拒絕
+#ifndef HUFF_DICT_H
+#define HUFF_DICT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_core.h"
+
+#define DICT_MAGIC        "HUFD"
+#define DICT_VERSION      1
+#define DICT_FILE_MAX     (4 + 1 + 4 + LENGTH_TABLE_MAX)
+#define DICT_HEADER_MAX   (4 + VARINT_MAX)
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    uint32_t id;
+    int max_len;
+    int lengths[MAX_SYMBOLS];
+    CodeEntry codes[MAX_SYMBOLS];
+    DecodeTable dt;
+} HuffDict;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 由樣本的直方圖建字典 (limit_L <= 0 表示不限制碼長)；limit_L 太小回傳 -1，用完要 dict_free */
+int    dict_train(const uint64_t freq[MAX_SYMBOLS], int limit_L, HuffDict* d);
+
+/* 字典檔內容寫到 out (最多 DICT_FILE_MAX byte)，回傳 byte 數 */
+size_t dict_save(const HuffDict* d, unsigned char* out);
+
+/* 從字典檔內容載入；格式不對回傳 -1，用完要 dict_free */
+int    dict_load(const unsigned char* in, size_t n, HuffDict* d);
+
+void   dict_free(HuffDict* d);
+
+/* 壓縮 n byte 最多需要多大的輸出 buffer */
+size_t dict_bound(const HuffDict* d, size_t n);
+
+/* 把 in 壓成一則訊息寫到 out (至少 dict_bound 大)，回傳 byte 數 */
+size_t dict_compress(const HuffDict* d, const unsigned char* in, size_t n, unsigned char* out);
+
+/* 讀出訊息的原始大小；ID 不對或格式不對回傳 -1 */
+int    dict_get_size(const HuffDict* d, const unsigned char* in, size_t len, uint64_t* size);
+
+/* 解一則訊息到 out (容量 cap)，*out_len 是原始大小
+   ID 不對或資料壞掉回傳 -1，cap 不夠回傳 -2 */
+int    dict_decompress(const HuffDict* d, const unsigned char* in, size_t len, unsigned char* out, size_t cap,
+                       size_t* out_len);
+
+#endif // HUFF_DICT_H
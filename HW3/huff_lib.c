@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#include "huff_lib.h"
+#include "huff_lz77.h"
+
+struct HuffCtx {
+    BlockOptions opt;
+    uint32_t block_size;
+    unsigned char* scratch;   // dst 剩下的空間不到 block_bound 時先壓到這裡
+    DecodeTable dt;           // 解碼表，block 之間沿用
+};
+
+// ==========================================
+// 1. Context
+// ==========================================
+
+HuffCtx* huff_ctx_create(const BlockOptions* opt, uint32_t block_size) {
+    if (block_size == 0) block_size = DEFAULT_BLOCK_SIZE;
+    if (block_size < MIN_BLOCK_SIZE || block_size > MAX_BLOCK_SIZE || (block_size & 1023)) return NULL;
+    if (opt && ((opt->streams != 1 && opt->streams != 4) || opt->limit_L > HUFF_MAX_BITS ||
+                (opt->order != 0 && opt->order != 1) || (opt->rle != 0 && opt->rle != 1) ||
+                opt->lz_level < 0 || opt->lz_level > LZ_MAX_LEVEL ||
+                (opt->lz_window != 0 && (opt->lz_window < LZ_MIN_WINDOW || opt->lz_window > LZ_MAX_WINDOW)) ||
+                (opt->backend != BACKEND_HUFFMAN && opt->backend != BACKEND_ANS) ||
+                opt->sample < 0 || opt->sample > SAMPLE_MAX_STRIDE)) return NULL;
+
+    HuffCtx* ctx = (HuffCtx*)calloc(1, sizeof(HuffCtx));
+    if (!ctx) return NULL;
+    ctx->opt.limit_L = opt ? opt->limit_L : 0;
+    ctx->opt.streams = opt ? opt->streams : 1;
+    ctx->opt.order = opt ? opt->order : 0;
+    ctx->opt.rle = opt ? opt->rle : 0;
+    ctx->opt.lz_level = opt ? opt->lz_level : 0;
+    ctx->opt.lz_window = opt ? opt->lz_window : 0;
+    ctx->opt.backend = opt ? opt->backend : BACKEND_HUFFMAN;
+    ctx->opt.sample = opt ? opt->sample : 0;
+    ctx->opt.stats = NULL;
+    ctx->block_size = block_size;
+    ctx->scratch = (unsigned char*)malloc(block_bound(block_size));
+    if (!ctx->scratch) {
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+void huff_ctx_free(HuffCtx* ctx) {
+    if (!ctx) return;
+    free(ctx->scratch);
+    free_decode_table(&ctx->dt);
+    free(ctx);
+}
+
+// ==========================================
+// 2. 壓縮
+// ==========================================
+
+size_t huff_compress_bound(const HuffCtx* ctx, size_t n) {
+    size_t blocks = n / ctx->block_size + 1;
+    return HUF2_HEADER_MAX + blocks * block_bound(0) + n + BLOCK_END_SIZE;
+}
+
+int huff_compress_buf(HuffCtx* ctx, const unsigned char* src, size_t n,
+                      unsigned char* dst, size_t cap, size_t* out_len) {
+    *out_len = 0;
+    if (!ctx || (!src && n) || (!dst && cap)) return HUFF_ERR_PARAM;
+
+    ContainerHeader ch;
+    ch.version = HUF2_VERSION;
+    ch.flags = 0;
+    ch.limit_L = (uint8_t)(ctx->opt.limit_L > 0 ? ctx->opt.limit_L : 0);
+    ch.block_size = ctx->block_size;
+    ch.original_size = n;
+    unsigned char hdr[HUF2_HEADER_MAX];
+    size_t pos = put_container_header(hdr, &ch);
+    if (pos > cap) return HUFF_ERR_DST_SMALL;
+    memcpy(dst, hdr, pos);
+
+    // 後面空間夠放最壞情況就直接壓進 dst，不夠才繞一趟 scratch 再看裝不裝得下
+    for (size_t off = 0; off < n; ) {
+        size_t m = n - off < ctx->block_size ? n - off : ctx->block_size;
+        int direct = cap - pos >= block_bound(m);
+        size_t w = compress_block(src + off, m, &ctx->opt, direct ? dst + pos : ctx->scratch);
+        if (w == 0) return HUFF_ERR_LIMIT;
+        if (!direct) {
+            if (w > cap - pos) return HUFF_ERR_DST_SMALL;
+            memcpy(dst + pos, ctx->scratch, w);
+        }
+        pos += w;
+        off += m;
+    }
+
+    if (cap - pos < BLOCK_END_SIZE) return HUFF_ERR_DST_SMALL;
+    dst[pos++] = BLOCK_END;
+    *out_len = pos;
+    return HUFF_OK;
+}
+
+// ==========================================
+// 3. 解壓縮
+// ==========================================
+
+// 檢查 magic 並讀檔頭，回傳第一個 block 的位置
+static int parse_header(const unsigned char* src, size_t n, ContainerHeader* ch) {
+    if (!src || n < 4 || memcmp(src, HUF2_MAGIC, 4) != 0) return HUFF_ERR_CORRUPT;
+    if (get_container_header(src + 4, n - 4, ch) < 0) return HUFF_ERR_CORRUPT;
+    return (int)ch->header_size;
+}
+
+int huff_get_size(const unsigned char* src, size_t n, uint64_t* size) {
+    ContainerHeader ch;
+    int rc = parse_header(src, n, &ch);
+    if (rc < 0) return rc;
+    if (ch.original_size == HUF2_SIZE_UNKNOWN) return HUFF_ERR_PARAM;
+    *size = ch.original_size;
+    return HUFF_OK;
+}
+
+int huff_decompress_buf(HuffCtx* ctx, const unsigned char* src, size_t n,
+                        unsigned char* dst, size_t cap, size_t* out_len) {
+    *out_len = 0;
+    if (!ctx || (!dst && cap)) return HUFF_ERR_PARAM;
+
+    ContainerHeader ch;
+    int rc = parse_header(src, n, &ch);
+    if (rc < 0) return rc;
+    if (ch.original_size != HUF2_SIZE_UNKNOWN && ch.original_size > cap) return HUFF_ERR_DST_SMALL;
+
+    // 每個 block 直接解進 dst 的對應位置
+    size_t pos = (size_t)rc;
+    size_t written = 0;
+    for (;;) {
+        BlockHeader bh;
+        int h = get_block_header(src + pos, n - pos, &bh);
+        if (h < 0) return HUFF_ERR_CORRUPT;
+        pos += (size_t)h;
+        if (bh.type == BLOCK_END) break;
+        if (bh.raw_size > ch.block_size || bh.comp_size > n - pos) return HUFF_ERR_CORRUPT;
+        if (bh.raw_size > cap - written) return HUFF_ERR_DST_SMALL;
+        if (decode_block_with(&bh, src + pos, dst + written, &ctx->dt, NULL) != 0) return HUFF_ERR_CORRUPT;
+        pos += bh.comp_size;
+        written += bh.raw_size;
+    }
+    if (ch.original_size != HUF2_SIZE_UNKNOWN && written != ch.original_size) return HUFF_ERR_CORRUPT;
+    *out_len = written;
+    return HUFF_OK;
+}
+
+// ==========================================
+// 4. 錯誤訊息
+// ==========================================
+
+const char* huff_error_string(int rc) {
+    switch (rc) {
+        case HUFF_OK:            return "ok";
+        case HUFF_ERR_MEM:       return "out of memory";
+        case HUFF_ERR_PARAM:     return "invalid argument";
+        case HUFF_ERR_DST_SMALL: return "destination buffer too small";
+        case HUFF_ERR_LIMIT:     return "code length limit too small";
+        case HUFF_ERR_CORRUPT:   return "corrupt or unsupported data";
+        default:                 return "unknown error";
+    }
+}
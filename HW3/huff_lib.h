@@ -0,0 +1,54 @@
+// huff_lib.h - 記憶體對記憶體的壓縮 / 解壓介面，給其他程式直接呼叫
+//
+// 輸出格式跟 main 的 HUF2 一樣 (沒有索引)，main -d 可以直接解
+// 整個過程只讀寫呼叫端給的 buffer，不碰檔案也不印任何東西，錯誤一律用回傳值表示
+// 一個 HuffCtx 裡放了解碼表和暫存區，重複使用同一個 ctx 就不用每次重新配置
+// 同一個 ctx 不能同時給兩個 thread 用；每個 thread 各建一個即可
+#ifndef HUFF_LIB_H
+#define HUFF_LIB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_block.h"
+
+// 回傳值
+#define HUFF_OK             0
+#define HUFF_ERR_MEM       -1   // 配置記憶體失敗
+#define HUFF_ERR_PARAM     -2   // 參數不合法
+#define HUFF_ERR_DST_SMALL -3   // 輸出 buffer 不夠大
+#define HUFF_ERR_LIMIT     -4   // limit_L 太小，裝不下所有符號
+#define HUFF_ERR_CORRUPT   -5   // 壓縮資料壞掉或不是 HUF2
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct HuffCtx HuffCtx;   // 內容只在 huff_lib.c 裡看得到
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* opt 是 NULL 表示不限碼長、1 條 stream、order-0、不做 RLE 和 LZ77、用 Huffman、不抽樣；block_size 是 0 表示 DEFAULT_BLOCK_SIZE
+   block_size 要是 KiB 的整數倍，範圍 MIN_BLOCK_SIZE..MAX_BLOCK_SIZE；不合法或配置失敗回傳 NULL */
+HuffCtx* huff_ctx_create(const BlockOptions* opt, uint32_t block_size);
+void     huff_ctx_free(HuffCtx* ctx);
+
+/* 壓縮 n byte 最多需要多大的輸出 buffer */
+size_t huff_compress_bound(const HuffCtx* ctx, size_t n);
+
+/* 把 src 壓成一個完整的 HUF2 檔寫進 dst (容量 cap)，*out_len 是寫出的 byte 數 */
+int huff_compress_buf(HuffCtx* ctx, const unsigned char* src, size_t n,
+                      unsigned char* dst, size_t cap, size_t* out_len);
+
+/* 把 HUF2 資料解到 dst (容量 cap)，*out_len 是解出的 byte 數 */
+int huff_decompress_buf(HuffCtx* ctx, const unsigned char* src, size_t n,
+                        unsigned char* dst, size_t cap, size_t* out_len);
+
+/* 從檔頭讀出原始大小 (用來決定解壓 buffer 要多大)；串流壓縮的檔沒有記錄，回傳 HUFF_ERR_PARAM */
+int huff_get_size(const unsigned char* src, size_t n, uint64_t* size);
+
+/* 回傳值的說明文字 */
+const char* huff_error_string(int rc);
+
+#endif // HUFF_LIB_H
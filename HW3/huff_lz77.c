@@ -0,0 +1,303 @@
+#include <stdlib.h>
+#include <string.h>
+#include "huff_lz77.h"
+
+// 每個等級：最多沿著 chain 看幾個候選、找到多長就不再找、要不要 lazy matching
+typedef struct {
+    int chain;
+    uint32_t nice;
+    int lazy;
+} LzLevel;
+
+static const LzLevel lz_levels[LZ_MAX_LEVEL + 1] = {
+    { 0, 0, 0 },
+    { 4, 16, 0 },  { 8, 32, 0 },     { 16, 64, 0 },
+    { 16, 64, 1 }, { 32, 128, 1 },   { 64, 256, 1 },
+    { 256, 512, 1 }, { 1024, 1024, 1 }, { 4096, 4096, 1 }
+};
+
+// ==========================================
+// 1. 值碼
+// ==========================================
+
+// v → 值碼，*extra_bits / *extra 是後面要接的附加值
+static int value_code(uint32_t v, int* extra_bits, uint32_t* extra) {
+    if (v < LZ_DIRECT_CODES) {
+        *extra_bits = 0;
+        *extra = 0;
+        return (int)v;
+    }
+    int hb = 4;
+    while (v >> (hb + 1)) hb++;
+    *extra_bits = hb - 1;
+    *extra = v & ((1u << (hb - 1)) - 1);
+    return LZ_DIRECT_CODES + (hb - 4) * 2 + (int)((v >> (hb - 1)) & 1);
+}
+
+// 讀一個值碼和附加值；失敗回傳 -1
+static int read_value(BitReader* br, const DecodeTable* t, uint32_t* v) {
+    int c = br_decode_symbol(br, t);
+    if (c < 0) return -1;
+    if (c < LZ_DIRECT_CODES) {
+        *v = (uint32_t)c;
+        return 0;
+    }
+    int extra_bits = (c - LZ_DIRECT_CODES) / 2 + 3;
+    if (extra_bits > 30) return -1;
+    uint32_t extra;
+    if (br_read_bits(br, extra_bits, &extra) != 0) return -1;
+    *v = ((2u | (uint32_t)((c - LZ_DIRECT_CODES) & 1)) << extra_bits) | extra;
+    return 0;
+}
+
+// ==========================================
+// 2. 找 match
+// ==========================================
+
+typedef struct {
+    const unsigned char* in;
+    size_t n;
+    int32_t* head;        // 每個 hash 最近一次出現的位置
+    int32_t* prev;        // 同一個 hash 的上一個位置 (以 window 為週期重複使用)
+    uint32_t mask;        // window - 1
+    size_t inserted;      // 這個位置之前的都已經加進 hash chain
+    LzLevel lv;
+} MatchFinder;
+
+static inline uint32_t hash4(const unsigned char* p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline void insert_until(MatchFinder* mf, size_t pos) {
+    for (; mf->inserted < pos && mf->inserted + LZ_MIN_MATCH <= mf->n; mf->inserted++) {
+        uint32_t h = hash4(mf->in + mf->inserted);
+        mf->prev[mf->inserted & mf->mask] = mf->head[h];
+        mf->head[h] = (int32_t)mf->inserted;
+    }
+}
+
+// 找位置 i 最長的 match (同時把 i 加進 chain)，回傳長度，不到 LZ_MIN_MATCH 回傳 0
+static uint32_t find_match(MatchFinder* mf, size_t i, uint32_t* dist) {
+    insert_until(mf, i);
+    const unsigned char* in = mf->in;
+    size_t max_len = mf->n - i;
+    int32_t cand = mf->head[hash4(in + i)];
+    uint32_t best = 0;
+    for (int k = 0; k < mf->lv.chain && cand >= 0; k++) {
+        size_t d = i - (size_t)cand;
+        if (d > mf->mask) break;   // 超出 window，再往前的 prev 也已經被蓋掉
+        // 先比目前最長那一格，不可能更長就不用逐 byte 比
+        if (best < max_len && in[cand + best] == in[i + best]) {
+            size_t len = 0;
+            while (len < max_len && in[cand + len] == in[i + len]) len++;
+            if (len > best) {
+                best = (uint32_t)len;
+                *dist = (uint32_t)d;
+                if (best >= mf->lv.nice || len == max_len) break;
+            }
+        }
+        cand = mf->prev[cand & mf->mask];
+    }
+    insert_until(mf, i + 1);
+    return best >= LZ_MIN_MATCH ? best : 0;
+}
+
+// ==========================================
+// 3. 建模 / 編碼
+// ==========================================
+
+int lz_build(const unsigned char* in, size_t n, int level, int window_bits, int limit_L, LzModel* m) {
+    if (level < 1) level = 1;
+    if (level > LZ_MAX_LEVEL) level = LZ_MAX_LEVEL;
+    if (window_bits < LZ_MIN_WINDOW || window_bits > LZ_MAX_WINDOW) window_bits = LZ_DEFAULT_WINDOW;
+    // window 比 block 大沒有意義，只會多配置 prev
+    while (window_bits > LZ_MIN_WINDOW && ((size_t)1 << (window_bits - 1)) >= n) window_bits--;
+
+    MatchFinder mf;
+    mf.in = in;
+    mf.n = n;
+    mf.mask = (1u << window_bits) - 1;
+    mf.inserted = 0;
+    mf.lv = lz_levels[level];
+    mf.head = (int32_t*)malloc(sizeof(int32_t) << LZ_HASH_BITS);
+    mf.prev = (int32_t*)malloc(sizeof(int32_t) << window_bits);
+    m->seq = (LzSeq*)malloc(sizeof(LzSeq) * (n / LZ_MIN_MATCH + 1));
+    m->count = 0;
+    if (!mf.head || !mf.prev || !m->seq) {
+        free(mf.head);
+        free(mf.prev);
+        lz_free(m);
+        return -1;
+    }
+    memset(mf.head, 0xFF, sizeof(int32_t) << LZ_HASH_BITS);
+
+    // greedy；lazy 的等級會先看下一個位置有沒有更長的 match，有就把這個 byte 當 literal
+    size_t i = 0, lit_start = 0;
+    while (i + LZ_MIN_MATCH <= n) {
+        uint32_t dist = 0;
+        uint32_t len = find_match(&mf, i, &dist);
+        if (len == 0) {
+            i++;
+            continue;
+        }
+        while (mf.lv.lazy && len < mf.lv.nice && i + 1 + LZ_MIN_MATCH <= n) {
+            uint32_t d2 = 0;
+            uint32_t l2 = find_match(&mf, i + 1, &d2);
+            if (l2 <= len) break;
+            i++;
+            len = l2;
+            dist = d2;
+        }
+        LzSeq* s = &m->seq[m->count++];
+        s->lit_run = (uint32_t)(i - lit_start);
+        s->match_len = len;
+        s->dist = dist;
+        i += len;
+        lit_start = i;
+        // 比 nice 還長的 match，中間的位置不加進 chain (省時間，也很少再用得到)
+        if (len > mf.lv.nice) mf.inserted = i;
+    }
+    LzSeq* last = &m->seq[m->count++];
+    last->lit_run = (uint32_t)(n - lit_start);
+    last->match_len = 0;
+    last->dist = 0;
+    free(mf.head);
+    free(mf.prev);
+
+    // 4 張表的頻率；附加值的 bit 數直接加進總數
+    int freq[LZ_TABLES][MAX_SYMBOLS];
+    memset(freq, 0, sizeof(freq));
+    uint64_t extra_total = 0;
+    const unsigned char* p = in;
+    for (size_t k = 0; k < m->count; k++) {
+        const LzSeq* s = &m->seq[k];
+        int eb;
+        uint32_t ev;
+        freq[LZ_LITLEN][value_code(s->lit_run, &eb, &ev)]++;
+        extra_total += (uint64_t)eb;
+        for (uint32_t j = 0; j < s->lit_run; j++) freq[LZ_LIT][p[j]]++;
+        p += s->lit_run + s->match_len;
+        if (s->match_len == 0) continue;
+        freq[LZ_MATCH][value_code(s->match_len - LZ_MIN_MATCH, &eb, &ev)]++;
+        extra_total += (uint64_t)eb;
+        freq[LZ_DIST][value_code(s->dist - 1, &eb, &ev)]++;
+        extra_total += (uint64_t)eb;
+    }
+
+    int limit = (limit_L <= 0 || limit_L > HUFF_MAX_BITS) ? HUFF_MAX_BITS : limit_L;
+    unsigned char table[LENGTH_TABLE_MAX];
+    unsigned char head[VARINT_MAX];
+    uint64_t bits = extra_total;
+    size_t size = put_varint(head, m->count);
+    for (int t = 0; t < LZ_TABLES; t++) {
+        int max_len = 0;
+        build_code_lengths(freq[t], m->lengths[t]);
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            if (m->lengths[t][s] > max_len) max_len = m->lengths[t][s];
+        }
+        if (max_len > limit && limit_code_lengths(freq[t], m->lengths[t], limit) != 0) {
+            lz_free(m);
+            return -1;
+        }
+        for (int s = 0; s < MAX_SYMBOLS; s++) bits += (uint64_t)freq[t][s] * (uint64_t)m->lengths[t][s];
+        size += put_length_table(m->lengths[t], table);
+    }
+    m->bits = bits;
+    m->size = size + (size_t)((bits + 7) / 8);
+    return 0;
+}
+
+size_t lz_encode(const unsigned char* in, const LzModel* m, unsigned char* out) {
+    unsigned char* p = out;
+    p += put_varint(p, m->count);
+    CodeEntry codes[LZ_TABLES][MAX_SYMBOLS];
+    for (int t = 0; t < LZ_TABLES; t++) {
+        p += put_length_table(m->lengths[t], p);
+        generate_limited_codes(m->lengths[t], codes[t]);
+    }
+
+    BitWriter bw;
+    bw_init_mem(&bw, p);
+    const CodeEntry* lit = codes[LZ_LIT];
+    for (size_t k = 0; k < m->count; k++) {
+        const LzSeq* s = &m->seq[k];
+        int eb;
+        uint32_t ev;
+        int c = value_code(s->lit_run, &eb, &ev);
+        bw_put(&bw, codes[LZ_LITLEN][c].code, codes[LZ_LITLEN][c].length);
+        if (eb) bw_put(&bw, ev, eb);
+        for (uint32_t j = 0; j < s->lit_run; j++) bw_put(&bw, lit[in[j]].code, lit[in[j]].length);
+        in += s->lit_run + s->match_len;
+        if (s->match_len == 0) continue;
+        c = value_code(s->match_len - LZ_MIN_MATCH, &eb, &ev);
+        bw_put(&bw, codes[LZ_MATCH][c].code, codes[LZ_MATCH][c].length);
+        if (eb) bw_put(&bw, ev, eb);
+        c = value_code(s->dist - 1, &eb, &ev);
+        bw_put(&bw, codes[LZ_DIST][c].code, codes[LZ_DIST][c].length);
+        if (eb) bw_put(&bw, ev, eb);
+    }
+    bw_finish(&bw);
+    return (size_t)(p - out) + (size_t)bw.total;
+}
+
+void lz_free(LzModel* m) {
+    free(m->seq);
+    m->seq = NULL;
+    m->count = 0;
+}
+
+// ==========================================
+// 4. 解碼
+// ==========================================
+
+int lz_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n) {
+    uint64_t count;
+    int k = get_varint(in, len, &count);
+    if (k < 0 || count == 0 || count > n / LZ_MIN_MATCH + 1) return -1;
+    size_t pos = (size_t)k;
+
+    DecodeTable dt[LZ_TABLES];
+    memset(dt, 0, sizeof(dt));
+    int rc = 0;
+    for (int t = 0; t < LZ_TABLES && rc == 0; t++) {
+        int lengths[MAX_SYMBOLS];
+        int used = get_length_table(in + pos, len - pos, lengths);
+        if (used < 0 || build_decode_table(&dt[t], lengths) != 0) rc = -1;
+        else pos += (size_t)used;
+    }
+
+    BitReader br;
+    br_init_mem(&br, in + pos, len - pos);
+    size_t done = 0;
+    for (uint64_t s = 0; s < count && rc == 0; s++) {
+        uint32_t run, mlen, dist;
+        // literal 一段一段用一般的批次解碼
+        if (read_value(&br, &dt[LZ_LITLEN], &run) != 0 || run > n - done ||
+            (run && br_decode_bytes(&br, &dt[LZ_LIT], out + done, run) != run)) {
+            rc = -1;
+            break;
+        }
+        done += run;
+        if (s == count - 1) break;
+        if (read_value(&br, &dt[LZ_MATCH], &mlen) != 0 || read_value(&br, &dt[LZ_DIST], &dist) != 0) {
+            rc = -1;
+            break;
+        }
+        mlen += LZ_MIN_MATCH;
+        dist += 1;
+        if (dist > done || mlen > n - done) {
+            rc = -1;
+            break;
+        }
+        // 距離比長度短時來源和目的重疊，只能逐 byte 複製 (這樣才會重複前面剛寫的內容)
+        unsigned char* dst = out + done;
+        const unsigned char* src = dst - dist;
+        if (dist >= mlen) memcpy(dst, src, mlen);
+        else for (uint32_t j = 0; j < mlen; j++) dst[j] = src[j];
+        done += mlen;
+    }
+    if (rc == 0 && done != n) rc = -1;
+    for (int t = 0; t < LZ_TABLES; t++) free_decode_table(&dt[t]);
+    return rc;
+}
@@ -0,0 +1,68 @@
+// huff_lz77.h - LZ77 前端：hash chain 找重複字串，再把 literal / 長度 / 距離用 canonical Huffman 編碼
+//
+// 一個 block 拆成一串「序列」：先照抄 lit_run 個 literal，再從 dist 個 byte 前複製 match_len 個 byte
+// 最後一個序列只有 literal。match 只往回找同一個 block 裡的資料，block 之間還是互相獨立 (可以平行解)
+// 碼長表都是 256 個符號，所以不像 DEFLATE 把 literal 和長度放在同一個字母表，而是分成 4 張表：
+//   LZ_LIT     : literal byte
+//   LZ_LITLEN  : lit_run           的值碼
+//   LZ_MATCH   : match_len - LZ_MIN_MATCH 的值碼
+//   LZ_DIST    : dist - 1          的值碼
+// 值碼：v < 16 直接是 v；否則設 v 的最高位是第 hb 位，碼 = 16 + (hb - 4) * 2 + 次高位，後面接 hb - 1 個 bit 的附加值
+//
+// BLOCK_LZ77 內容 : 序列數 (varint) | 4 張碼長表 (依上面的順序) | bitstream
+//   bitstream 每個序列 : lit_run 碼 + 附加值 | literal × lit_run | match_len 碼 + 附加值 | dist 碼 + 附加值
+//   最後一個序列只有前兩項
+#ifndef HUFF_LZ77_H
+#define HUFF_LZ77_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_core.h"
+
+#define LZ_MIN_MATCH      4
+#define LZ_HASH_BITS      15
+#define LZ_MIN_WINDOW     10    // window 以 2 的次方 (bit 數) 表示
+#define LZ_MAX_WINDOW     22    // 4 MiB，跟最大的 block 一樣
+#define LZ_DEFAULT_WINDOW 16
+#define LZ_MAX_LEVEL      9
+#define LZ_MIN_BLOCK      64    // 再小就不找 match 了
+#define LZ_DIRECT_CODES   16    // 值碼 0..15 沒有附加值
+
+// 4 張表的編號
+enum { LZ_LIT, LZ_LITLEN, LZ_MATCH, LZ_DIST, LZ_TABLES };
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    uint32_t lit_run;     // 先照抄幾個 literal
+    uint32_t match_len;   // 0 = 最後一個序列 (沒有 match)
+    uint32_t dist;
+} LzSeq;
+
+typedef struct {
+    LzSeq* seq;
+    size_t count;                              // 序列數 (含最後一個)
+    int lengths[LZ_TABLES][MAX_SYMBOLS];
+    uint64_t bits;                             // bitstream 的 bit 數 (含附加值)
+    size_t size;                               // 編出來的 block 內容會是幾個 byte
+} LzModel;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 用 level (1..LZ_MAX_LEVEL，越大找越久) 和 2^window_bits 的 window 拆出序列，再算出 4 張表的碼長
+   limit_L <= 0 表示不限制碼長；成功回傳 0，用完要 lz_free */
+int    lz_build(const unsigned char* in, size_t n, int level, int window_bits, int limit_L, LzModel* m);
+
+/* 依 m 把 in 編成 BLOCK_LZ77 的內容，回傳 byte 數 (就是 m->size) */
+size_t lz_encode(const unsigned char* in, const LzModel* m, unsigned char* out);
+
+void   lz_free(LzModel* m);
+
+/* 解 BLOCK_LZ77 的內容 (len byte) 成 n 個 byte；資料壞掉回傳 -1 */
+int    lz_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n);
+
+#endif // HUFF_LZ77_H
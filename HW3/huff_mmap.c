@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_mmap.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ==========================================
+// Windows：CreateFileMapping + MapViewOfFile
+// ==========================================
+
+#ifdef _WIN32
+
+static int map_handle(FILE* fp, uint64_t size, int writable, MappedFile* mf) {
+    HANDLE fh = (HANDLE)_get_osfhandle(_fileno(fp));
+    if (fh == INVALID_HANDLE_VALUE) return -1;
+    // 寫入用的映射給了大小，檔案會自動變成這麼大
+    HANDLE mh = CreateFileMappingA(fh, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                   (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (!mh) return -1;
+    void* p = MapViewOfFile(mh, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (SIZE_T)size);
+    if (!p) {
+        CloseHandle(mh);
+        return -1;
+    }
+    mf->data = (unsigned char*)p;
+    mf->size = (size_t)size;
+    mf->handle = mh;
+    return 0;
+}
+
+int map_input(FILE* fp, MappedFile* mf) {
+    mf->data = NULL;
+    struct _stat64 st;
+    if (_fstat64(_fileno(fp), &st) != 0 || !(st.st_mode & _S_IFREG) || st.st_size <= 0) return -1;
+    if ((uint64_t)st.st_size > (uint64_t)SIZE_MAX) return -1;
+    return map_handle(fp, (uint64_t)st.st_size, 0, mf);
+}
+
+int map_output(FILE* fp, uint64_t size, MappedFile* mf) {
+    mf->data = NULL;
+    if (size == 0 || size > (uint64_t)SIZE_MAX) return -1;
+    // 映射從檔頭開始寫，只接受空的一般檔案；沒有寫入權限時 CreateFileMapping 自己會失敗
+    struct _stat64 st;
+    if (_fstat64(_fileno(fp), &st) != 0 || !(st.st_mode & _S_IFREG) || st.st_size != 0) return -1;
+    fflush(fp);
+    return map_handle(fp, size, 1, mf);
+}
+
+void unmap_file(MappedFile* mf, FILE* fp, uint64_t keep) {
+    if (!mf->data) return;
+    UnmapViewOfFile(mf->data);
+    CloseHandle((HANDLE)mf->handle);
+    if (fp && keep < mf->size) _chsize_s(_fileno(fp), (long long)keep);
+    mf->data = NULL;
+}
+
+// ==========================================
+// POSIX：mmap
+// ==========================================
+
+#else
+
+int map_input(FILE* fp, MappedFile* mf) {
+    mf->data = NULL;
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return -1;
+    if ((uint64_t)st.st_size > (uint64_t)SIZE_MAX) return -1;
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (p == MAP_FAILED) return -1;
+    // 從頭讀到尾只掃一次，請核心提早預讀
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    mf->data = (unsigned char*)p;
+    mf->size = (size_t)st.st_size;
+    return 0;
+}
+
+int map_output(FILE* fp, uint64_t size, MappedFile* mf) {
+    mf->data = NULL;
+    if (size == 0 || size > (uint64_t)SIZE_MAX) return -1;
+    int fd = fileno(fp);
+    // 要能讀寫、不是附加模式 (>> 導向)，而且是空的一般檔案：映射從檔頭開始寫，不能蓋到原本的內容
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || (fl & O_ACCMODE) != O_RDWR || (fl & O_APPEND)) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != 0) return -1;
+    fflush(fp);
+    if (ftruncate(fd, (off_t)size) != 0) return -1;
+    void* p = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        // 拿掉剛剛加長的部分，檔案回到原本的空檔，呼叫端接著用 fwrite
+        if (ftruncate(fd, st.st_size) != 0) { /* 已經失敗了，沒有別的能做 */ }
+        return -1;
+    }
+    mf->data = (unsigned char*)p;
+    mf->size = (size_t)size;
+    return 0;
+}
+
+void unmap_file(MappedFile* mf, FILE* fp, uint64_t keep) {
+    if (!mf->data) return;
+    munmap(mf->data, mf->size);
+    if (fp && keep < mf->size && ftruncate(fileno(fp), (off_t)keep) != 0) {
+        fprintf(stderr, "truncate output failed\n");
+    }
+    mf->data = NULL;
+}
+
+#endif
@@ -0,0 +1,35 @@
+// huff_mmap.h - 把一般檔案整個映射進記憶體，省掉 stdio 的複製
+#ifndef HUFF_MMAP_H
+#define HUFF_MMAP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    unsigned char* data;   // NULL = 沒有映射
+    size_t size;
+#ifdef _WIN32
+    void* handle;          // CreateFileMapping 拿到的 HANDLE
+#endif
+} MappedFile;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 唯讀映射整個輸入檔；不是一般檔案、空檔或是映射失敗回傳 -1 (呼叫端改用 fread) */
+int  map_input(FILE* fp, MappedFile* mf);
+
+/* 把輸出檔設成 size byte 後可讀寫映射；fp 要是自己用 "w+b" 開的空檔 (stdout 不要傳進來)
+   不能讀寫、附加模式或不是空檔時回傳 -1，檔案維持原狀 (呼叫端改用 fwrite) */
+int  map_output(FILE* fp, uint64_t size, MappedFile* mf);
+
+/* 解除映射；輸出檔只留前 keep byte (keep >= size 表示不截) */
+void unmap_file(MappedFile* mf, FILE* fp, uint64_t keep);
+
+#endif // HUFF_MMAP_H
@@ -0,0 +1,221 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "huff_order1.h"
+
+// ==========================================
+// 1. 分組
+// ==========================================
+
+// 一個 context 裡出現過的符號，分組時只看這些
+typedef struct {
+    uint16_t count;           // 有幾個不同的符號
+    uint8_t  sym[MAX_SYMBOLS];
+} ContextSymbols;
+
+// 照 context 的出現次數由大到小排 (最多 256 個，插入排序就夠快，也不用另外包成 {次數, context} 給 qsort 比)
+static void sort_by_total(int* order, int count, const uint32_t totals[MAX_SYMBOLS]) {
+    for (int i = 1; i < count; i++) {
+        int c = order[i];
+        int j = i;
+        while (j > 0 && totals[order[j - 1]] < totals[c]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = c;
+    }
+}
+
+// 把 context c 編進組 g 要幾個 bit (用組的平滑機率估計)
+static double group_cost(const uint32_t hist[MAX_SYMBOLS], const ContextSymbols* cs,
+                         const double cost[MAX_SYMBOLS]) {
+    double bits = 0.0;
+    for (int k = 0; k < cs->count; k++) bits += hist[cs->sym[k]] * cost[cs->sym[k]];
+    return bits;
+}
+
+int order1_build(const unsigned char* in, size_t n, int limit_L, Order1Model* m) {
+    uint32_t (*hist)[MAX_SYMBOLS] = (uint32_t (*)[MAX_SYMBOLS])calloc(MAX_SYMBOLS, sizeof(*hist));
+    ContextSymbols* cs = (ContextSymbols*)malloc(sizeof(ContextSymbols) * MAX_SYMBOLS);
+    uint64_t (*gh)[MAX_SYMBOLS] = (uint64_t (*)[MAX_SYMBOLS])malloc(ORDER1_MAX_GROUPS * sizeof(*gh));
+    if (!hist || !cs || !gh) {
+        free(hist);
+        free(cs);
+        free(gh);
+        return -1;
+    }
+
+    // order-1 直方圖：hist[前一個 byte][這個 byte]
+    uint32_t totals[MAX_SYMBOLS] = {0};
+    unsigned prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        hist[prev][in[i]]++;
+        prev = in[i];
+    }
+    int order[MAX_SYMBOLS];
+    int active = 0;
+    for (int c = 0; c < MAX_SYMBOLS; c++) {
+        cs[c].count = 0;
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            if (hist[c][s]) {
+                cs[c].sym[cs[c].count++] = (uint8_t)s;
+                totals[c] += hist[c][s];
+            }
+        }
+        if (totals[c]) order[active++] = c;
+    }
+    sort_by_total(order, active, totals);
+
+    // 組數受 block 大小限制；一開始用出現最多的 k 個 context 當各組的中心
+    int k = (int)(n / ORDER1_BYTES_PER_GROUP);
+    if (k > ORDER1_MAX_GROUPS) k = ORDER1_MAX_GROUPS;
+    if (k > active) k = active;
+    if (k < 1) k = 1;
+    memset(m->map, 0, sizeof(m->map));
+    for (int g = 0; g < k; g++) m->map[order[g]] = (uint8_t)g;
+    for (int g = 0; g < k; g++) {
+        for (int s = 0; s < MAX_SYMBOLS; s++) gh[g][s] = hist[order[g]][s];
+    }
+
+    // k-means：每個 context 換到代價最小的組，再重算各組直方圖，直到沒有人換組
+    static const double eps = 0.5;   // 平滑：組裡沒出現過的符號也給一點機率
+    double cost[ORDER1_MAX_GROUPS][MAX_SYMBOLS];
+    for (int it = 0; it < ORDER1_ITERS; it++) {
+        for (int g = 0; g < k; g++) {
+            uint64_t tot = 0;
+            for (int s = 0; s < MAX_SYMBOLS; s++) tot += gh[g][s];
+            double lt = log2((double)tot + eps * MAX_SYMBOLS);
+            for (int s = 0; s < MAX_SYMBOLS; s++) cost[g][s] = lt - log2((double)gh[g][s] + eps);
+        }
+        int moved = 0;
+        for (int a = 0; a < active; a++) {
+            int c = order[a];
+            int best = m->map[c];
+            double best_bits = group_cost(hist[c], &cs[c], cost[best]);
+            for (int g = 0; g < k; g++) {
+                double bits = group_cost(hist[c], &cs[c], cost[g]);
+                if (bits < best_bits) {
+                    best_bits = bits;
+                    best = g;
+                }
+            }
+            moved += best != m->map[c];
+            m->map[c] = (uint8_t)best;
+        }
+        memset(gh, 0, ORDER1_MAX_GROUPS * sizeof(*gh));
+        for (int a = 0; a < active; a++) {
+            int c = order[a];
+            for (int j = 0; j < cs[c].count; j++) gh[m->map[c]][cs[c].sym[j]] += hist[c][cs[c].sym[j]];
+        }
+        if (!moved && it > 0) break;
+    }
+
+    // 拿掉空的組並重新編號；沒出現過的 context 放在第 0 組
+    int renum[ORDER1_MAX_GROUPS];
+    int groups = 0;
+    for (int g = 0; g < k; g++) {
+        uint64_t tot = 0;
+        for (int s = 0; s < MAX_SYMBOLS; s++) tot += gh[g][s];
+        renum[g] = tot ? groups++ : -1;
+        if (tot && renum[g] != g) memcpy(gh[renum[g]], gh[g], sizeof(*gh));
+    }
+    for (int c = 0; c < MAX_SYMBOLS; c++) m->map[c] = totals[c] ? (uint8_t)renum[m->map[c]] : 0;
+    m->groups = groups;
+
+    // 每組照一般的方式算碼長 (必要時限制長度)，順便算出編碼後的大小
+    int limit = (limit_L <= 0 || limit_L > HUFF_MAX_BITS) ? HUFF_MAX_BITS : limit_L;
+    unsigned char table[LENGTH_TABLE_MAX];
+    uint64_t bits = 0;
+    size_t size = 1 + ORDER1_MAP_SIZE;
+    int rc = 0;
+    for (int g = 0; g < groups && rc == 0; g++) {
+        int freq[MAX_SYMBOLS];
+        int max_len = 0;
+        for (int s = 0; s < MAX_SYMBOLS; s++) freq[s] = (int)gh[g][s];
+        build_code_lengths(freq, m->lengths[g]);
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            if (m->lengths[g][s] > max_len) max_len = m->lengths[g][s];
+        }
+        if (max_len > limit && limit_code_lengths(freq, m->lengths[g], limit) != 0) rc = -1;
+        for (int s = 0; s < MAX_SYMBOLS; s++) bits += (uint64_t)freq[s] * (uint64_t)m->lengths[g][s];
+        size += put_length_table(m->lengths[g], table);
+    }
+    m->bits = bits;
+    m->size = size + (size_t)((bits + 7) / 8);
+
+    free(hist);
+    free(cs);
+    free(gh);
+    return rc;
+}
+
+// ==========================================
+// 2. 編碼 / 解碼
+// ==========================================
+
+size_t order1_encode(const unsigned char* in, size_t n, const Order1Model* m, unsigned char* out) {
+    unsigned char* p = out;
+    *p++ = (unsigned char)m->groups;
+    for (int c = 0; c < MAX_SYMBOLS; c += 2) *p++ = (unsigned char)(m->map[c] | (m->map[c + 1] << 4));
+    for (int g = 0; g < m->groups; g++) p += put_length_table(m->lengths[g], p);
+
+    // 每個 context 直接指到自己那組的碼，內層迴圈不用再查 map
+    uint32_t code[ORDER1_MAX_GROUPS][MAX_SYMBOLS];
+    int len[ORDER1_MAX_GROUPS][MAX_SYMBOLS];
+    for (int g = 0; g < m->groups; g++) {
+        CodeEntry codes[MAX_SYMBOLS];
+        generate_limited_codes(m->lengths[g], codes);
+        for (int s = 0; s < MAX_SYMBOLS; s++) {
+            code[g][s] = codes[s].code;
+            len[g][s] = codes[s].length;
+        }
+    }
+    const uint32_t* ctx_code[MAX_SYMBOLS];
+    const int* ctx_len[MAX_SYMBOLS];
+    for (int c = 0; c < MAX_SYMBOLS; c++) {
+        ctx_code[c] = code[m->map[c]];
+        ctx_len[c] = len[m->map[c]];
+    }
+
+    BitWriter bw;
+    bw_init_mem(&bw, p);
+    unsigned prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned s = in[i];
+        bw_put(&bw, ctx_code[prev][s], ctx_len[prev][s]);
+        prev = s;
+    }
+    bw_finish(&bw);
+    return (size_t)(p - out) + (size_t)bw.total;
+}
+
+int order1_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n) {
+    if (len < 1 + ORDER1_MAP_SIZE) return -1;
+    int groups = in[0];
+    if (groups < 1 || groups > ORDER1_MAX_GROUPS) return -1;
+    uint8_t map[MAX_SYMBOLS];
+    for (int c = 0; c < MAX_SYMBOLS; c += 2) {
+        map[c] = in[1 + c / 2] & 15;
+        map[c + 1] = in[1 + c / 2] >> 4;
+        if (map[c] >= groups || map[c + 1] >= groups) return -1;
+    }
+    size_t pos = 1 + ORDER1_MAP_SIZE;
+
+    DecodeTable dt[ORDER1_MAX_GROUPS];
+    memset(dt, 0, sizeof(dt));
+    int rc = 0;
+    for (int g = 0; g < groups && rc == 0; g++) {
+        int lengths[MAX_SYMBOLS];
+        int used = get_length_table(in + pos, len - pos, lengths);
+        if (used < 0 || build_decode_table(&dt[g], lengths) != 0) rc = -1;
+        else pos += (size_t)used;
+    }
+
+    if (rc == 0) {
+        const DecodeTable* ctx_dt[MAX_SYMBOLS];
+        for (int c = 0; c < MAX_SYMBOLS; c++) ctx_dt[c] = &dt[map[c]];
+        rc = decode_buffer_ctx(in + pos, len - pos, ctx_dt, out, n);
+    }
+    for (int g = 0; g < groups; g++) free_decode_table(&dt[g]);
+    return rc;
+}
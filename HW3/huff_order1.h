@@ -0,0 +1,47 @@
+// huff_order1.h - order-1 context 模型：依前一個 byte 選碼表
+//
+// 每個 context (前一個 byte，block 開頭當作 0) 都有自己的直方圖；256 張表太佔檔頭，
+// 所以把分布相近的 context 分成最多 ORDER1_MAX_GROUPS 組，每組一張 canonical 碼表
+// 分組用 k-means：組的代價是「用這組的機率編這個 context」要幾個 bit
+//
+// BLOCK_ORDER1 內容 : 組數 (1 byte) | context → 組 (256 個 4 bit，128 bytes) | 每組的碼長表 | bitstream
+#ifndef HUFF_ORDER1_H
+#define HUFF_ORDER1_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "huff_core.h"
+
+#define ORDER1_MAX_GROUPS     16
+#define ORDER1_MAP_SIZE       (MAX_SYMBOLS / 2)
+#define ORDER1_MIN_BLOCK      4096    // 再小的 block 多出來的表不划算，直接用 order-0
+#define ORDER1_BYTES_PER_GROUP 2048   // 平均每組至少要有這麼多 byte，不然表比省下的還大
+#define ORDER1_ITERS          8
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    int groups;
+    uint8_t map[MAX_SYMBOLS];                     // 前一個 byte → 組
+    int lengths[ORDER1_MAX_GROUPS][MAX_SYMBOLS];  // 每組的碼長
+    uint64_t bits;                                // bitstream 的 bit 數
+    size_t size;                                  // 編出來的 block 內容會是幾個 byte
+} Order1Model;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 統計 order-1 直方圖、分組並算出每組碼長 (limit_L <= 0 表示不限制)
+   回傳 0；limit_L 太小或配置失敗回傳 -1 */
+int    order1_build(const unsigned char* in, size_t n, int limit_L, Order1Model* m);
+
+/* 依 m 把 in 編成 BLOCK_ORDER1 的內容，回傳 byte 數 (就是 m->size) */
+size_t order1_encode(const unsigned char* in, size_t n, const Order1Model* m, unsigned char* out);
+
+/* 解 BLOCK_ORDER1 的內容 (len byte) 成 n 個 byte；資料壞掉回傳 -1 */
+int    order1_decode(const unsigned char* in, size_t len, unsigned char* out, size_t n);
+
+#endif // HUFF_ORDER1_H
@@ -0,0 +1,576 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+#include "huff_block.h"
+#include "huff_parallel.h"
+
+// ==========================================
+// 資料結構定義
+// ==========================================
+
+#define RING_CACHE_LINE 64
+
+// 單一生產者、單一消費者的環狀佇列 (lock-free)：只有生產者改 tail，只有消費者改 head
+// head / tail 放在不同的 cache line，兩邊不會互相搶
+typedef struct {
+    _Atomic uint32_t head;
+    char pad0[RING_CACHE_LINE - sizeof(_Atomic uint32_t)];
+    _Atomic uint32_t tail;
+    char pad1[RING_CACHE_LINE - sizeof(_Atomic uint32_t)];
+    void** items;
+    uint32_t mask;
+} SpscRing;
+
+// pipeline 裡流動的一個 block
+typedef struct {
+    const unsigned char* in;     // 壓縮：原始資料；解壓：block 內容 (指到 buf 或是輸入映射)
+    unsigned char* buf;          // fread 讀進來的地方 (有輸入映射時是 NULL)
+    unsigned char* out;          // 壓縮：壓好的 block；解壓：解開的資料 (有輸出映射時是 NULL)
+    const unsigned char* data;   // 解壓：要寫出去的資料 (stored block 直接指到 in)
+    BlockHeader bh;              // 解壓：block 頭
+    uint64_t raw_offset;         // 解壓：在原始檔裡的位置
+    size_t n;                    // 壓縮：原始 byte 數
+    size_t m;                    // 壓縮：壓縮後 byte 數 (0 = 失敗)
+    int rc;                      // 解壓：0 = 成功
+} PipeSlot;
+
+// reader → coder → writer 三段：
+//   reader thread 拿空的 slot 讀一個 block，第 seq 個交給 coder seq % coders
+//   coder thread 各自壓 / 解，放進自己往 writer 的佇列
+//   writer (呼叫端的 thread) 依序輪流從每條 coder 的佇列拿，順序就跟讀入時一樣，寫完把 slot 還給 reader
+// 每條佇列都只有一個生產者和一個消費者；容量不小於 slot 總數 + 結束記號，放的時候不會滿
+// 每個 slot 都帶著一個 block 的輸入和輸出緩衝區，讀、算、寫各自在不同的 slot 上同時進行
+typedef struct {
+    FILE* fin;
+    FILE* fout;
+    const MappedFile* src;
+    MappedFile* dst;
+    const BlockOptions* opt;     // 壓縮用
+    const ContainerHeader* ch;   // 解壓用
+    uint32_t block_size;
+    int coders;
+    PipeSlot* slots;
+    int num_slots;
+    SpscRing free_ring;          // writer → reader：用完的 slot
+    SpscRing* to_coder;          // reader → 每條 coder
+    SpscRing* to_writer;         // 每條 coder → writer
+    atomic_int abort;            // writer 出錯：reader 不要再讀，coder 不要再算
+    int read_rc;                 // reader 停下的原因；writer 拿到結束記號 (NULL) 後才讀
+    HuffStats* stats;            // 呼叫端的統計 (只有 writer 直接寫)，NULL = 不記
+    HuffStats* mine;             // reader 一份 + 每條 coder 一份，結束時加進 stats
+} Pipeline;
+
+typedef struct {
+    Pipeline* p;
+    int id;
+} CoderArg;
+
+// ==========================================
+// Lock-free 佇列
+// ==========================================
+
+static int ring_init(SpscRing* r, uint32_t min_cap) {
+    uint32_t cap = 1;
+    while (cap < min_cap) cap <<= 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->mask = cap - 1;
+    r->items = (void**)malloc(cap * sizeof(void*));
+    return r->items ? 0 : -1;
+}
+
+// 呼叫端保證不會滿
+static void ring_push(SpscRing* r, void* item) {
+    uint32_t t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    r->items[t & r->mask] = item;
+    atomic_store_explicit(&r->tail, t + 1, memory_order_release);
+}
+
+// 先空轉一下，再讓出 CPU，等太久就小睡 (reader 卡在慢的磁碟時，coder 不要一直佔著 CPU)
+static void ring_backoff(int spin) {
+    if (spin < 64) return;
+    if (spin < 128) {
+        sched_yield();
+        return;
+    }
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec ts = { 0, 50000 };   // 50 µs
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// 空的時候等到有東西為止
+static void* ring_pop(SpscRing* r) {
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    for (int spin = 0; atomic_load_explicit(&r->tail, memory_order_acquire) == h; spin++) ring_backoff(spin);
+    void* item = r->items[h & r->mask];
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+    return item;
+}
+
+// ==========================================
+// Pipeline 的建立 / 執行 / 收尾
+// ==========================================
+
+static void pipeline_free(Pipeline* p) {
+    if (p->slots) {
+        for (int i = 0; i < p->num_slots; i++) {
+            free(p->slots[i].buf);
+            free(p->slots[i].out);
+        }
+    }
+    if (p->to_coder) {
+        for (int i = 0; i < p->coders; i++) free(p->to_coder[i].items);
+    }
+    if (p->to_writer) {
+        for (int i = 0; i < p->coders; i++) free(p->to_writer[i].items);
+    }
+    free(p->free_ring.items);
+    free(p->slots);
+    free(p->to_coder);
+    free(p->to_writer);
+    free(p->mine);
+}
+
+// 配置 slot 和佇列；in_size / out_size 是 0 表示那一邊有映射，不用緩衝區
+static int pipeline_init(Pipeline* p, int coders, size_t in_size, size_t out_size) {
+    p->coders = coders;
+    // 每條 coder 一個在算、一個排隊，另外 reader 和 writer 各拿著一個
+    p->num_slots = 2 * coders + 2;
+    atomic_init(&p->abort, 0);
+    p->read_rc = PAR_OK;
+    p->slots = (PipeSlot*)calloc((size_t)p->num_slots, sizeof(PipeSlot));
+    p->to_coder = (SpscRing*)calloc((size_t)coders, sizeof(SpscRing));
+    p->to_writer = (SpscRing*)calloc((size_t)coders, sizeof(SpscRing));
+    p->mine = p->stats ? (HuffStats*)malloc(sizeof(HuffStats) * (size_t)(coders + 1)) : NULL;
+    p->free_ring.items = NULL;
+    if (!p->slots || !p->to_coder || !p->to_writer || (p->stats && !p->mine)) return -1;
+    uint32_t cap = (uint32_t)p->num_slots + 1;
+    if (ring_init(&p->free_ring, cap) != 0) return -1;
+    for (int i = 0; i < coders; i++) {
+        if (ring_init(&p->to_coder[i], cap) != 0 || ring_init(&p->to_writer[i], cap) != 0) return -1;
+    }
+    for (int i = 0; i < p->num_slots; i++) {
+        PipeSlot* s = &p->slots[i];
+        if (in_size && !(s->buf = (unsigned char*)malloc(in_size))) return -1;
+        if (out_size && !(s->out = (unsigned char*)malloc(out_size))) return -1;
+        ring_push(&p->free_ring, s);
+    }
+    if (p->stats) {
+        for (int i = 0; i <= coders; i++) stats_init(&p->mine[i]);
+    }
+    return 0;
+}
+
+// 開 reader 和 coder 的 thread；開不了時還沒讀任何輸入，收掉已經開的並回傳 -1
+static int pipeline_start(Pipeline* p, pthread_t* tids, CoderArg* args,
+                          void* (*reader)(void*), void* (*coder)(void*)) {
+    int started;
+    for (started = 0; started < p->coders; started++) {
+        args[started].p = p;
+        args[started].id = started;
+        if (pthread_create(&tids[started], NULL, coder, &args[started]) != 0) break;
+    }
+    if (started == p->coders && pthread_create(&tids[p->coders], NULL, reader, p) == 0) return 0;
+    for (int i = 0; i < started; i++) ring_push(&p->to_coder[i], NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    return -1;
+}
+
+// writer 收到結束記號之後：等所有 thread 結束，統計加回呼叫端那份
+static void pipeline_join(Pipeline* p, pthread_t* tids) {
+    for (int i = 0; i <= p->coders; i++) pthread_join(tids[i], NULL);
+    if (p->stats) {
+        for (int i = 0; i <= p->coders; i++) stats_merge(p->stats, &p->mine[i]);
+    }
+}
+
+// reader 讀完 (或被叫停) 時每條 coder 都送一個結束記號，coder 再轉給 writer
+static void reader_finish(Pipeline* p, int rc) {
+    p->read_rc = rc;
+    for (int i = 0; i < p->coders; i++) ring_push(&p->to_coder[i], NULL);
+}
+
+// ==========================================
+// 壓縮
+// ==========================================
+
+static void* compress_reader(void* arg) {
+    Pipeline* p = (Pipeline*)arg;
+    HuffStats* st = p->stats ? &p->mine[p->coders] : NULL;
+    uint64_t src_pos = 0;
+    int rc = PAR_OK;
+    for (uint64_t seq = 0;; seq++) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p->free_ring);
+        if (atomic_load_explicit(&p->abort, memory_order_relaxed)) break;
+        size_t n;
+        if (p->src) {
+            n = p->src->size - src_pos < p->block_size ? (size_t)(p->src->size - src_pos) : p->block_size;
+            s->in = p->src->data + src_pos;
+            src_pos += n;
+        }
+        else {
+            double t = st ? stats_now() : 0.0;
+            n = fread(s->buf, 1, p->block_size, p->fin);
+            if (st) stats_lap(st, STAT_READ, t);
+            s->in = s->buf;
+            if (n == 0 && ferror(p->fin)) rc = PAR_ERR_IO;
+        }
+        if (n == 0) break;
+        s->n = n;
+        ring_push(&p->to_coder[seq % (uint64_t)p->coders], s);
+    }
+    reader_finish(p, rc);
+    return NULL;
+}
+
+static void* compress_coder(void* arg) {
+    CoderArg* a = (CoderArg*)arg;
+    Pipeline* p = a->p;
+    BlockOptions opt = *p->opt;
+    opt.stats = p->stats ? &p->mine[a->id] : NULL;
+    for (;;) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p->to_coder[a->id]);
+        if (s && !atomic_load_explicit(&p->abort, memory_order_relaxed)) {
+            s->m = compress_block(s->in, s->n, &opt, s->out);
+        }
+        ring_push(&p->to_writer[a->id], s);
+        if (!s) break;
+    }
+    return NULL;
+}
+
+int compress_blocks_parallel(FILE* fin, FILE* fout, const BlockOptions* opt, uint32_t block_size, int threads,
+                             BlockIndex* idx, const MappedFile* src) {
+    Pipeline p;
+    memset(&p, 0, sizeof(p));
+    p.fin = fin;
+    p.src = src;
+    p.opt = opt;
+    p.block_size = block_size;
+    p.stats = opt->stats;
+    pthread_t* tids = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)(threads + 1));
+    CoderArg* args = (CoderArg*)malloc(sizeof(CoderArg) * (size_t)threads);
+    if (!tids || !args || pipeline_init(&p, threads, src ? 0 : block_size, block_bound(block_size)) != 0 ||
+        pipeline_start(&p, tids, args, compress_reader, compress_coder) != 0) {
+        pipeline_free(&p);
+        free(tids);
+        free(args);
+        return PAR_ERR_MEM;
+    }
+
+    // writer：出錯後還是繼續拿，把 slot 還給 reader，直到結束記號
+    int rc = PAR_OK;
+    HuffStats* st = opt->stats;
+    for (uint64_t seq = 0;; seq++) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p.to_writer[seq % (uint64_t)threads]);
+        if (!s) break;
+        if (rc == PAR_OK) {
+            double t = st ? stats_now() : 0.0;
+            if (s->m == 0) rc = PAR_ERR_LIMIT;
+            else if (fwrite(s->out, 1, s->m, fout) != s->m || index_add(idx, (uint32_t)s->n, (uint32_t)s->m) != 0) {
+                rc = PAR_ERR_IO;
+            }
+            if (st) stats_lap(st, STAT_WRITE, t);
+            if (rc != PAR_OK) atomic_store(&p.abort, 1);
+        }
+        ring_push(&p.free_ring, s);
+    }
+    pipeline_join(&p, tids);
+    if (rc == PAR_OK) rc = p.read_rc;
+    pipeline_free(&p);
+    free(tids);
+    free(args);
+    return rc;
+}
+
+// ==========================================
+// 指定位置讀寫
+// ==========================================
+
+#ifdef _WIN32
+// Windows 沒有 pread/pwrite：鎖住後 seek 再讀寫
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int read_at(FILE* fp, void* buf, size_t n, uint64_t off) {
+    pthread_mutex_lock(&io_lock);
+    int ok = file_seek(fp, (int64_t)off, SEEK_SET) == 0 && fread(buf, 1, n, fp) == n;
+    pthread_mutex_unlock(&io_lock);
+    return ok ? 0 : -1;
+}
+
+static int write_at(FILE* fp, const void* buf, size_t n, uint64_t off) {
+    pthread_mutex_lock(&io_lock);
+    int ok = file_seek(fp, (int64_t)off, SEEK_SET) == 0 && fwrite(buf, 1, n, fp) == n;
+    pthread_mutex_unlock(&io_lock);
+    return ok ? 0 : -1;
+}
+#else
+// pread/pwrite 自帶位置，多條 thread 可以同時對同一個檔案讀寫
+static int read_at(FILE* fp, void* buf, size_t n, uint64_t off) {
+    int fd = fileno(fp);
+    unsigned char* p = (unsigned char*)buf;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, (off_t)off);
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+        off += (uint64_t)r;
+    }
+    return 0;
+}
+
+static int write_at(FILE* fp, const void* buf, size_t n, uint64_t off) {
+    int fd = fileno(fp);
+    const unsigned char* p = (const unsigned char*)buf;
+    while (n > 0) {
+        ssize_t r = pwrite(fd, p, n, (off_t)off);
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+        off += (uint64_t)r;
+    }
+    return 0;
+}
+#endif
+
+// ==========================================
+// 平行解壓
+// ==========================================
+
+typedef struct {
+    pthread_mutex_t lock;
+    FILE* fin;
+    FILE* fout;
+    const BlockIndex* idx;
+    const MappedFile* src;   // 輸入映射 (可以是 NULL)
+    MappedFile* dst;         // 輸出映射 (可以是 NULL)
+    uint32_t block_size;
+    HuffStats* stats;        // 可以是 NULL
+    size_t next;       // 下一個還沒人拿的 block
+    int rc;
+} DecompressJob;
+
+static void* decompress_worker(void* arg) {
+    DecompressJob* job = (DecompressJob*)arg;
+    unsigned char* in_buf = job->src ? NULL : (unsigned char*)malloc(block_bound(job->block_size));
+    unsigned char* out_buf = job->dst ? NULL : (unsigned char*)malloc(job->block_size);
+    int rc = ((job->src || in_buf) && (job->dst || out_buf)) ? PAR_OK : PAR_ERR_MEM;
+    DecodeTable dt;   // 每個 thread 一份，block 之間沿用
+    memset(&dt, 0, sizeof(dt));
+    HuffStats mine;
+    if (job->stats) stats_init(&mine);
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        if (rc != PAR_OK && job->rc == PAR_OK) job->rc = rc;
+        size_t i = job->next++;
+        int stop = job->rc != PAR_OK || i >= job->idx->count;
+        pthread_mutex_unlock(&job->lock);
+        if (stop) break;
+
+        // 讀 → 解 → 寫到原始檔裡的位置，block 之間完全獨立
+        // 有映射的那一邊直接用映射裡的位置，不用另外讀寫
+        const IndexEntry* e = &job->idx->entries[i];
+        const unsigned char* payload = in_buf;
+        unsigned char* out = job->dst ? job->dst->data + e->raw_offset : out_buf;
+        BlockHeader bh;
+        if (job->src) {
+            if (e->comp_offset + e->comp_size > job->src->size) {
+                rc = PAR_ERR_DATA;
+                continue;
+            }
+            payload = job->src->data + e->comp_offset;
+        }
+        else if (read_at(job->fin, in_buf, e->comp_size, e->comp_offset) != 0) {
+            rc = PAR_ERR_IO;
+            continue;
+        }
+        int h = get_block_header(payload, e->comp_size, &bh);
+        if (h < 0 || bh.raw_size != e->raw_size || h + bh.comp_size != e->comp_size ||
+            decode_block_with(&bh, payload + h, out, &dt, job->stats ? &mine : NULL) != 0) {
+            rc = PAR_ERR_DATA;
+            continue;
+        }
+        if (!job->dst && write_at(job->fout, out, e->raw_size, e->raw_offset) != 0) {
+            rc = PAR_ERR_IO;
+        }
+    }
+    free(in_buf);
+    free(out_buf);
+    free_decode_table(&dt);
+    if (job->stats) {
+        pthread_mutex_lock(&job->lock);
+        stats_merge(job->stats, &mine);
+        pthread_mutex_unlock(&job->lock);
+    }
+    return NULL;
+}
+
+int decompress_blocks_parallel(FILE* fin, FILE* fout, const ContainerHeader* ch, const BlockIndex* idx,
+                               int threads, const MappedFile* src, MappedFile* dst, HuffStats* stats) {
+    DecompressJob job;
+    job.fin = fin;
+    job.fout = fout;
+    job.idx = idx;
+    job.src = src;
+    job.dst = (dst && dst->size >= idx->raw_pos) ? dst : NULL;
+    job.block_size = ch->block_size;
+    job.stats = stats;
+    job.next = 0;
+    job.rc = PAR_OK;
+    fflush(fout);
+
+    pthread_t* tids = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (!tids) return PAR_ERR_MEM;
+    pthread_mutex_init(&job.lock, NULL);
+    int started;
+    for (started = 0; started < threads; started++) {
+        if (pthread_create(&tids[started], NULL, decompress_worker, &job) != 0) break;
+    }
+    if (started == 0) {
+        decompress_worker(&job); // 開不了 thread 就自己做
+    }
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&job.lock);
+    free(tids);
+    return job.rc;
+}
+
+// ==========================================
+// 依序解壓的 pipeline (不需要索引)
+// ==========================================
+
+static void* decompress_reader(void* arg) {
+    Pipeline* p = (Pipeline*)arg;
+    const ContainerHeader* ch = p->ch;
+    HuffStats* st = p->stats ? &p->mine[p->coders] : NULL;
+    uint64_t pos = ch->header_size;
+    uint64_t raw = 0;
+    int rc = PAR_ERR_EOF;
+    for (uint64_t seq = 0;; seq++) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p->free_ring);
+        if (atomic_load_explicit(&p->abort, memory_order_relaxed)) {
+            rc = PAR_OK;
+            break;
+        }
+        double t = st ? stats_now() : 0.0;
+        BlockHeader bh;
+        if (p->src) {
+            int h = get_block_header(p->src->data + pos, p->src->size - pos, &bh);
+            if (h < 0) break;
+            pos += (uint64_t)h;
+        }
+        else if (read_block_header(p->fin, &bh) < 0) {
+            break;
+        }
+        if (bh.type == BLOCK_END) {
+            rc = PAR_OK;
+            break;
+        }
+        if (bh.raw_size > ch->block_size || bh.comp_size > block_bound(ch->block_size) ||
+            (p->dst && bh.raw_size > p->dst->size - raw)) {
+            rc = PAR_ERR_DATA;
+            break;
+        }
+        if (p->src) {
+            if (p->src->size - pos < bh.comp_size) break;
+            s->in = p->src->data + pos;
+            pos += bh.comp_size;
+        }
+        else {
+            if (fread(s->buf, 1, bh.comp_size, p->fin) != bh.comp_size) break;
+            s->in = s->buf;
+        }
+        if (st) stats_lap(st, STAT_READ, t);
+        s->bh = bh;
+        s->raw_offset = raw;
+        raw += bh.raw_size;
+        ring_push(&p->to_coder[seq % (uint64_t)p->coders], s);
+    }
+    reader_finish(p, rc);
+    return NULL;
+}
+
+static void* decompress_coder(void* arg) {
+    CoderArg* a = (CoderArg*)arg;
+    Pipeline* p = a->p;
+    HuffStats* st = p->stats ? &p->mine[a->id] : NULL;
+    DecodeTable dt;   // 每條 coder 一份，block 之間沿用
+    memset(&dt, 0, sizeof(dt));
+    for (;;) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p->to_coder[a->id]);
+        if (s && !atomic_load_explicit(&p->abort, memory_order_relaxed)) {
+            if (s->bh.type == BLOCK_STORED && !p->dst && s->bh.comp_size == s->bh.raw_size) {
+                // 原始資料：writer 直接從讀進來的地方寫出去
+                s->data = s->in;
+                s->rc = 0;
+                if (st) st->blocks++;
+            }
+            else {
+                unsigned char* out = p->dst ? p->dst->data + s->raw_offset : s->out;
+                s->rc = decode_block_with(&s->bh, s->in, out, &dt, st);
+                s->data = out;
+            }
+        }
+        ring_push(&p->to_writer[a->id], s);
+        if (!s) break;
+    }
+    free_decode_table(&dt);
+    return NULL;
+}
+
+int decompress_pipeline(FILE* fin, FILE* fout, const ContainerHeader* ch, int threads,
+                        const MappedFile* src, MappedFile* dst, HuffStats* stats, uint64_t* written) {
+    Pipeline p;
+    memset(&p, 0, sizeof(p));
+    p.fin = fin;
+    p.src = src;
+    p.dst = dst;
+    p.ch = ch;
+    p.block_size = ch->block_size;
+    p.stats = stats;
+    *written = 0;
+    pthread_t* tids = (pthread_t*)malloc(sizeof(pthread_t) * (size_t)(threads + 1));
+    CoderArg* args = (CoderArg*)malloc(sizeof(CoderArg) * (size_t)threads);
+    if (!tids || !args ||
+        pipeline_init(&p, threads, src ? 0 : block_bound(ch->block_size), dst ? 0 : ch->block_size) != 0 ||
+        pipeline_start(&p, tids, args, decompress_reader, decompress_coder) != 0) {
+        pipeline_free(&p);
+        free(tids);
+        free(args);
+        return PAR_ERR_MEM;
+    }
+
+    // writer：有輸出映射時 coder 已經解在最終位置，這裡只算進度
+    int rc = PAR_OK;
+    for (uint64_t seq = 0;; seq++) {
+        PipeSlot* s = (PipeSlot*)ring_pop(&p.to_writer[seq % (uint64_t)threads]);
+        if (!s) break;
+        if (rc == PAR_OK) {
+            double t = stats ? stats_now() : 0.0;
+            if (s->rc != 0) rc = PAR_ERR_DATA;
+            else if (!dst && fwrite(s->data, 1, s->bh.raw_size, fout) != s->bh.raw_size) rc = PAR_ERR_IO;
+            else *written += s->bh.raw_size;
+            if (stats && !dst) stats_lap(stats, STAT_WRITE, t);
+            if (rc != PAR_OK) atomic_store(&p.abort, 1);
+        }
+        ring_push(&p.free_ring, s);
+    }
+    pipeline_join(&p, tids);
+    if (rc == PAR_OK) rc = p.read_rc;
+    pipeline_free(&p);
+    free(tids);
+    free(args);
+    return rc;
+}
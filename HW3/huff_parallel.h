@@ -0,0 +1,43 @@
+// huff_parallel.h - 多執行緒分塊壓縮 / 解壓縮
+//
+// 依序處理時用三段 pipeline：reader thread 讀 block、coder thread 壓 / 解、writer (呼叫端) 依序寫出
+// 三段之間用 lock-free 的單一生產者單一消費者佇列串起來，讀、算、寫可以同時進行 (只有一條 coder 也一樣)
+// 有索引的檔案解壓時另外有隨機存取的版本：每條 worker 自己讀、解、寫到最終位置
+#ifndef HUFF_PARALLEL_H
+#define HUFF_PARALLEL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_block.h"
+#include "huff_mmap.h"
+
+#define MAX_THREADS 256
+
+// 回傳碼
+#define PAR_OK         0
+#define PAR_ERR_MEM   -1
+#define PAR_ERR_IO    -2
+#define PAR_ERR_LIMIT -3   // 碼長限制太小，某個 block 編不出來
+#define PAR_ERR_DATA  -4   // 壓縮檔內容壞掉
+#define PAR_ERR_EOF   -5   // 壓縮檔在結束 block 之前就斷了
+
+/* 從 fin 讀到檔尾，切成 block_size 的 block 交給 threads 條 coder 壓縮 (pipeline)
+   每個 block 有自己的頻率表和碼長表，寫出的順序和讀入順序相同；寫出的 block 依序記進 idx
+   src 不是 NULL 時直接從映射切 block，不經過 fread
+   回傳 PAR_ERR_MEM 時還沒讀任何輸入，呼叫端可以改用單執行緒 */
+int compress_blocks_parallel(FILE* fin, FILE* fout, const BlockOptions* opt, uint32_t block_size, int threads,
+                             BlockIndex* idx, const MappedFile* src);
+
+/* 依 block 索引把 block 分給 threads 條 worker 解壓，各自直接寫到輸出檔的最終位置
+   fin / fout 都必須是可以 seek 的一般檔案；src / dst 有映射時直接在映射上讀寫
+   stats 不是 NULL 時加總每條 worker 的建表 / 解碼時間 */
+int decompress_blocks_parallel(FILE* fin, FILE* fout, const ContainerHeader* ch, const BlockIndex* idx,
+                               int threads, const MappedFile* src, MappedFile* dst, HuffStats* stats);
+
+/* 從 fin 目前位置 (檔頭後面) 依序解到結束 block，threads 條 coder (pipeline)，不需要索引
+   src / dst 有映射時直接在映射上讀寫；*written 是依序成功寫出的 byte 數
+   回傳 PAR_OK、PAR_ERR_DATA (block 壞掉)、PAR_ERR_EOF、PAR_ERR_IO；PAR_ERR_MEM 時還沒讀任何輸入 */
+int decompress_pipeline(FILE* fin, FILE* fout, const ContainerHeader* ch, int threads,
+                        const MappedFile* src, MappedFile* dst, HuffStats* stats, uint64_t* written);
+
+#endif // HUFF_PARALLEL_H
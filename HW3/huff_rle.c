@@ -0,0 +1,83 @@
+#include <string.h>
+#include "huff_core.h"
+#include "huff_rle.h"
+
+// ==========================================
+// 1. 編碼
+// ==========================================
+
+size_t rle_encode(const unsigned char* in, size_t n, unsigned char* out, size_t cap) {
+    size_t o = 0, lit = 0, k = 0;
+    while (k < n) {
+        // 往後找第一個連續 RLE_MIN_RUN 個一樣的 byte，前面 (含這 RLE_MIN_RUN 個) 整段照抄
+        unsigned prev = MAX_SYMBOLS;
+        int run = 0;
+        for (; k < n; k++) {
+            run = (in[k] == prev) ? run + 1 : 1;
+            prev = in[k];
+            if (run == RLE_MIN_RUN) break;
+        }
+        size_t end = (k < n) ? k + 1 : n;
+        if (o + (end - lit) + VARINT_MAX > cap) return 0;
+        memcpy(out + o, in + lit, end - lit);
+        o += end - lit;
+        if (k == n) break;
+
+        // 再長的部分只記次數
+        size_t e = end;
+        while (e < n && in[e] == prev) e++;
+        o += put_varint(out + o, e - end);
+        lit = k = e;
+    }
+    return o;
+}
+
+// ==========================================
+// 2. 還原
+// ==========================================
+
+void rle_decoder_init(RleDecoder* d) {
+    d->prev = -1;
+    d->run = 0;
+    d->counting = 0;
+    d->shift = 0;
+    d->count = 0;
+}
+
+int rle_expand(RleDecoder* d, const unsigned char* in, size_t len, unsigned char* out, size_t cap,
+               size_t* produced) {
+    size_t w = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned b = in[i];
+        if (d->counting) {
+            if (d->shift > 28) return -1;   // block 不會超過 32 bit
+            d->count |= (uint64_t)(b & 0x7F) << d->shift;
+            d->shift += 7;
+            if (b & 0x80) continue;
+            if (d->count > cap - w) return -1;
+            memset(out + w, d->prev, (size_t)d->count);
+            w += (size_t)d->count;
+            d->counting = 0;
+            d->run = 0;
+            continue;
+        }
+        if (w == cap) return -1;
+        out[w++] = (unsigned char)b;
+        if ((int)b == d->prev) d->run++;
+        else {
+            d->prev = (int)b;
+            d->run = 1;
+        }
+        if (d->run == RLE_MIN_RUN) {
+            d->counting = 1;
+            d->shift = 0;
+            d->count = 0;
+        }
+    }
+    *produced = w;
+    return 0;
+}
+
+int rle_finished(const RleDecoder* d) {
+    return !d->counting;
+}
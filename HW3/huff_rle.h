@@ -0,0 +1,47 @@
+// huff_rle.h - run-length 前處理：同一個 byte 連續很多次時先縮短再做 Huffman
+//
+// Huffman 每個 byte 至少要 1 bit，全 0 或大片填充的資料最好也只能壓到 1/8；先做 RLE 就沒有這個下限
+// 格式：原始 byte 照抄，同一個 byte 連續出現 RLE_MIN_RUN 次之後緊接一個 varint，表示後面還重複幾次 (可以是 0)
+//       varint 之後重新計算連續次數
+// BLOCK_RLE 內容 : RLE 之後的長度 (varint) | 碼長表 | bitstream (RLE 之後的資料，只有 1 條 stream)
+// 解碼端邊解 bitstream 邊還原，一次只解 RLE_CHUNK 個 byte，不用另外配置整個 block 的暫存區
+#ifndef HUFF_RLE_H
+#define HUFF_RLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RLE_MIN_RUN 4
+#define RLE_CHUNK   4096   // 解碼時一次解多少 RLE 之後的 byte
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+// 還原的狀態，資料可以分很多段餵進來 (varint 可能被切在兩段中間)
+typedef struct {
+    int      prev;       // 上一個照抄的 byte，還沒有是 -1
+    int      run;        // prev 已經連續照抄了幾次
+    int      counting;   // 正在讀重複次數的 varint
+    int      shift;
+    uint64_t count;
+} RleDecoder;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 把 in 做 RLE 寫到 out；結果會超過 cap byte 時 (不划算) 中途放棄回傳 0 */
+size_t rle_encode(const unsigned char* in, size_t n, unsigned char* out, size_t cap);
+
+void rle_decoder_init(RleDecoder* d);
+
+/* 還原一段 RLE 資料 (len byte) 接著寫到 out (還剩 cap byte)，*produced 是寫出的 byte 數
+   超過 cap 或重複次數不合理回傳 -1 */
+int rle_expand(RleDecoder* d, const unsigned char* in, size_t len, unsigned char* out, size_t cap,
+               size_t* produced);
+
+/* 最後一段餵完之後檢查有沒有停在 varint 中間 */
+int rle_finished(const RleDecoder* d);
+
+#endif // HUFF_RLE_H
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "huff_stats.h"
+
+static const char* phase_names[STAT_PHASES] = {
+    "read", "count", "rle", "match", "lengths", "limit", "codes", "encode", "write", "table", "decode"
+};
+
+// ==========================================
+// 1. 計時 / 累計
+// ==========================================
+
+void stats_init(HuffStats* s) {
+    memset(s, 0, sizeof(*s));
+    s->bytes_in = s->bytes_out = STATS_UNKNOWN;
+}
+
+double stats_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+double stats_lap(HuffStats* s, int phase, double t0) {
+    double t = stats_now();
+    s->phase[phase] += t - t0;
+    return t;
+}
+
+void stats_merge(HuffStats* dst, const HuffStats* src) {
+    for (int i = 0; i < STAT_PHASES; i++) dst->phase[i] += src->phase[i];
+    dst->blocks += src->blocks;
+    dst->payload_bits += src->payload_bits;
+    dst->table_bytes += src->table_bytes;
+    for (int i = 0; i < MAX_SYMBOLS; i++) dst->freq[i] += src->freq[i];
+    if (src->decode_table_bytes > dst->decode_table_bytes) dst->decode_table_bytes = src->decode_table_bytes;
+    dst->sampled_blocks += src->sampled_blocks;
+    dst->sample_loss_bits += src->sample_loss_bits;
+}
+
+double stats_entropy(const HuffStats* s) {
+    uint64_t total = 0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) total += s->freq[i];
+    if (total == 0) return -1.0;
+    double h = 0.0;
+    for (int i = 0; i < MAX_SYMBOLS; i++) {
+        if (s->freq[i] == 0) continue;
+        double p = (double)s->freq[i] / (double)total;
+        h -= p * log2(p);
+    }
+    return h;
+}
+
+// ==========================================
+// 2. JSON 輸出
+// ==========================================
+
+// 拿不到的數字輸出 null，儀表板那邊才分得出「0」和「不知道」
+static void put_u64(FILE* fp, const char* key, uint64_t v) {
+    if (v == STATS_UNKNOWN) fprintf(fp, "\"%s\":null", key);
+    else fprintf(fp, "\"%s\":%llu", key, (unsigned long long)v);
+}
+
+static void put_real(FILE* fp, const char* key, double v, int valid) {
+    if (valid) fprintf(fp, "\"%s\":%.6f", key, v);
+    else fprintf(fp, "\"%s\":null", key);
+}
+
+void stats_write_json(FILE* fp, const HuffStats* s, const char* mode, int threads, double total_sec) {
+    int compress = strcmp(mode, "compress") == 0;
+    // 原始資料那一邊：壓縮時是輸入，解壓時是輸出
+    uint64_t raw = compress ? s->bytes_in : s->bytes_out;
+    uint64_t packed = compress ? s->bytes_out : s->bytes_in;
+    int have_raw = raw != STATS_UNKNOWN && raw > 0;
+    double entropy = stats_entropy(s);
+
+    fprintf(fp, "{\"mode\":\"%s\",", mode);
+    if (s->format) fprintf(fp, "\"format\":\"%s\",", s->format);
+    else fputs("\"format\":null,", fp);
+    fprintf(fp, "\"threads\":%d,", threads);
+    put_real(fp, "total_sec", total_sec, 1);
+    fputc(',', fp);
+    put_u64(fp, "bytes_in", s->bytes_in);
+    fputc(',', fp);
+    put_u64(fp, "bytes_out", s->bytes_out);
+    fputc(',', fp);
+    put_real(fp, "ratio", have_raw ? (double)packed / (double)raw : 0.0, have_raw && packed != STATS_UNKNOWN);
+    fputc(',', fp);
+    put_real(fp, "mb_per_sec", have_raw && total_sec > 0 ? (double)raw / total_sec / 1e6 : 0.0,
+             have_raw && total_sec > 0);
+    fprintf(fp, ",\"blocks\":%llu,\"phase_sec\":{", (unsigned long long)s->blocks);
+    for (int i = 0; i < STAT_PHASES; i++) {
+        fprintf(fp, "%s\"%s\":%.6f", i ? "," : "", phase_names[i], s->phase[i]);
+    }
+    fputs("},", fp);
+    put_real(fp, "entropy_bits", entropy, entropy >= 0);
+    fputc(',', fp);
+    put_real(fp, "payload_bits_per_symbol", have_raw ? (double)s->payload_bits / (double)raw : 0.0,
+             have_raw && s->payload_bits > 0);
+    fputc(',', fp);
+    put_real(fp, "total_bits_per_symbol", have_raw ? 8.0 * (double)packed / (double)raw : 0.0,
+             have_raw && packed != STATS_UNKNOWN);
+    fprintf(fp, ",\"table_bytes\":%llu,\"decode_table_bytes\":%zu,\"sampled_blocks\":%llu,",
+            (unsigned long long)s->table_bytes, s->decode_table_bytes, (unsigned long long)s->sampled_blocks);
+    // 抽樣的損失：輸出比每個 block 都用完整直方圖時大了百分之幾
+    double loss = (double)s->sample_loss_bits / 8.0;
+    int have_loss = s->sampled_blocks > 0 && packed != STATS_UNKNOWN && (double)packed > loss;
+    put_real(fp, "sample_loss_pct", have_loss ? 100.0 * loss / ((double)packed - loss) : 0.0, have_loss);
+    fputs("}\n", fp);
+}
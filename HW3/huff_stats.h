@@ -0,0 +1,70 @@
+// huff_stats.h - --stats：各階段計時、byte 數、熵，最後輸出成 JSON
+//
+// 呼叫端把 HuffStats 指標放進 BlockOptions.stats (或直接傳給解碼函式)，NULL 就完全不計時
+// 多 thread 時每條 worker 各記一份，結束時 stats_merge 加總，所以階段秒數是 CPU 時間的總和
+#ifndef HUFF_STATS_H
+#define HUFF_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "huff_core.h"
+
+#define STATS_UNKNOWN UINT64_MAX   // byte 數拿不到 (pipe)
+
+// 階段
+enum {
+    STAT_READ,      // 讀輸入
+    STAT_COUNT,     // 統計頻率
+    STAT_RLE,       // run-length 前處理 (含統計 RLE 之後的頻率)
+    STAT_MATCH,     // LZ77 找 match + 算 4 張表的碼長
+    STAT_LENGTHS,   // 算碼長
+    STAT_LIMIT,     // package-merge 限制碼長
+    STAT_CODES,     // 產生 canonical 碼 + 寫碼長表
+    STAT_ENCODE,    // 編 bitstream
+    STAT_WRITE,     // 寫輸出
+    STAT_TABLE,     // 解碼：讀碼長表 + 建解碼表
+    STAT_DECODE,    // 解碼：解 bitstream
+    STAT_PHASES
+};
+
+// ==========================================
+// 資料結構定義 (Data Structures)
+// ==========================================
+
+typedef struct {
+    const char* format;            // "HUF1" / "HUF2" / "HUFA"，還不知道是 NULL
+    double   phase[STAT_PHASES];   // 每個階段累計的秒數
+    uint64_t bytes_in;             // 讀進來的 byte 數
+    uint64_t bytes_out;            // 寫出去的 byte 數
+    uint64_t blocks;
+    uint64_t payload_bits;         // bitstream 本身的 bit 數 (不含檔頭、碼長表、跳躍表)
+    uint64_t table_bytes;          // 碼長表總共幾個 byte
+    uint64_t freq[MAX_SYMBOLS];    // 壓縮時整個輸入的直方圖 (算熵用)
+    size_t   decode_table_bytes;   // 最大的一張解碼表佔多少記憶體
+    uint64_t sampled_blocks;       // 用抽樣碼表編的 block 數 (-f)
+    int64_t  sample_loss_bits;     // 這些 block 比用完整直方圖多花的 bit 數 (含碼長表)
+} HuffStats;
+
+// ==========================================
+// 函式原型宣告 (Function Prototypes)
+// ==========================================
+
+/* 全部清成 0，byte 數設成 STATS_UNKNOWN */
+void   stats_init(HuffStats* s);
+
+/* 單調遞增的時鐘 (秒)，不受系統時間調整影響 */
+double stats_now(void);
+
+/* 把 now - t0 記到 phase，回傳 now (接著量下一個階段) */
+double stats_lap(HuffStats* s, int phase, double t0);
+
+/* 把 src 加進 dst (byte 數除外，那是呼叫端最後填的) */
+void   stats_merge(HuffStats* dst, const HuffStats* src);
+
+/* 直方圖的 Shannon 熵 (bit/符號)；沒有直方圖回傳負值 */
+double stats_entropy(const HuffStats* s);
+
+/* 輸出一行 JSON；mode 是 "compress" 或 "decompress" */
+void   stats_write_json(FILE* fp, const HuffStats* s, const char* mode, int threads, double total_sec);
+
+#endif // HUFF_STATS_H
@@ -3,13 +3,12 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include "huff_core.h"
 
 // 定義可以執行的模式
 #define MODE_NONE 0
 #define MODE_C    1
 #define MODE_D    2
-#define MAX_SYMBOLS 256
-#define MAX_CODE_LEN 256
 #define MAX_PSEUDO 256
 
 // 定義鏈結串列結構
@@ -27,22 +26,17 @@ typedef struct {
     unsigned int code; // 用整數存 bit
 } HuffmanCodeEntry;
 
-// 建立碼表
-typedef struct {
-    unsigned int code;
-    unsigned char length;
-    unsigned char symbol;
-} CodeEntry;
-
 // 計算出現頻率
 int count_frequency(FILE* fin, int * fre_array){
     if (!fin) {
         perror("Cannot open input.txt");
         return 1;
     }
-    int c;
-    while ((c = fgetc(fin)) != EOF) { // 一個字一個字讀取
-        fre_array[c]++;
+    // 一次讀一大塊再整塊統計
+    unsigned char buf[HUFF_IO_BUF];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fin)) > 0) {
+        count_block_frequency(buf, n, fre_array);
     }
     // 印出頻率
     for (int i = 0; i < 256; i++) {
@@ -100,15 +94,6 @@ HuffmanNode* build_huffman_tree(int freq[MAX_SYMBOLS]) {
     return nodes[0]; // 根節點
 }
 
-// 輔助函式：將二進位字串轉換為無符號整數
-unsigned int code_to_uint(const char* code_str) {
-    unsigned int acc = 0;
-    for (int k = 0; code_str[k]; k++) {
-        acc = (acc << 1) | (code_str[k] == '1');
-    }
-    return acc;
-}
-
 // 產生編碼
 void generate_codes(HuffmanNode* node, char* code, int depth, char codes[MAX_SYMBOLS][MAX_CODE_LEN]) {
     printf("check01\n");
@@ -141,52 +126,6 @@ void generate_codes(HuffmanNode* node, char* code, int depth, char codes[MAX_SYM
     }
 }
 
-// 產生有限制長度的編碼
-void generate_limited_codes(int lengths[MAX_SYMBOLS], char codes[MAX_SYMBOLS][MAX_CODE_LEN]) {
-    // 確定最大碼字長度
-    int max_len = 0;
-    for (int i = 0; i < MAX_SYMBOLS; i++) { 
-        if (lengths[i] > max_len) {
-            max_len = lengths[i];
-        }
-    }
-        
-    // 計算每種長度的數量
-    int bl_count[MAX_CODE_LEN + 1] = {0};
-    for (int i = 0; i < MAX_SYMBOLS; i++){
-        if (lengths[i] > 0){
-            bl_count[lengths[i]]++;
-        }
-    }
-        
-    // 計算每個長度的起始碼值
-    int next_code[MAX_CODE_LEN + 1] = {0};
-    int code = 0;
-
-    // Canonical: 計算每個長度的起始 code
-    for (int len = 1; len <= max_len; len++) {
-        code = (code + bl_count[len-1]) << 1;
-        next_code[len] = code;
-    }
-
-    // 產生每個 symbol 的 code
-    for (int i = 0; i < MAX_SYMBOLS; i++) {
-        int len = lengths[i];
-        if (len == 0) {
-            codes[i][0] = '\0';
-            continue;
-        }
-
-        int c = next_code[len]++;
-
-        // 變成字串
-        for (int b = len - 1; b >= 0; b--)
-            codes[i][len - 1 - b] = ((c >> b) & 1) ? '1' : '0';
-
-        codes[i][len] = '\0';
-    }
-}
-
 // 釋放 Huffman Tree 記憶體
 void free_tree(HuffmanNode* node) {
     if (!node) return;
@@ -209,19 +148,18 @@ void calculate_code_lengths(HuffmanNode* node, int depth, int lengths[MAX_SYMBOL
 
 // 只針對「出現過的符號」(lengths[i] > 0) 做事
 // 只在超過 limit_length 時才套用長度限制
-// 將每個符號的長度都改成 limit_length
-// 否則不更動
-int fix_code_lengths(int lengths[MAX_SYMBOLS], int limit_length, char codes[MAX_SYMBOLS][MAX_CODE_LEN]) {
-    if (limit_length <= 0) { // 沒有限制，直接用原碼長
-        return 0; 
+// 用 package-merge 重新分配碼長，常用的符號仍然保持短碼
+// 否則不更動 (沒有限制時也不能超過解碼器上限 HUFF_MAX_BITS)
+int fix_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS], int limit_length) {
+    if (limit_length <= 0 || limit_length > HUFF_MAX_BITS) { // 沒有限制，用解碼器上限
+        limit_length = HUFF_MAX_BITS;
     }
-    int present[MAX_SYMBOLS];
     int k = 0, max_len = 0;
 
     // 蒐集「真的出現過」的符號，並找原本的最大碼長
     for (int i = 0; i < MAX_SYMBOLS; i++) {
         if (lengths[i] > 0) {
-            present[k++] = i;
+            k++;
             if (lengths[i] > max_len) max_len = lengths[i];
         }
     }
@@ -234,29 +172,22 @@ int fix_code_lengths(int lengths[MAX_SYMBOLS], int limit_length, char codes[MAX_
             fprintf(stderr, "Error: L=%d CAN'T ENCODE %d SYMBOLS NEED L >= ceil(log2(%d)\n", limit_length, k, k);
             exit(1);
         }
-        // 將每個 code 全部設為 L，確保可解
-        for (int i = 0; i < k; i++) {
-            lengths[present[i]] = limit_length;
-        }
-        return 1;     // 沒超過限制：完全不更動
+        // 在不超過 L 的條件下求最佳碼長
+        limit_code_lengths(freq, lengths, limit_length);
+        return 1;
     }
 }
 
-// 寫入符號、長度、碼值 並印出
-int write_full_header(FILE* fout, uint32_t original_size, const int lengths[256], char codes[256][MAX_CODE_LEN]) {
-    // 寫入原始資料大小 original_size
-    if (fwrite(&original_size, sizeof(uint32_t), 1, fout) != 1) { 
-        return -1;
-    }
-    // 計算有效符號數量
-    uint16_t num = 0;
-    for (int i = 0; i < 256; i++) {
-        if (lengths[i] > 0) {
-            num++;
-        }
-    }
-    // 寫入有效符號數量 num
-    if (fwrite(&num, sizeof(uint16_t), 1, fout) != 1) { 
+// 寫入原始大小和壓縮過的碼長表 並印出碼表
+// 碼是 canonical，解碼端只要長度就能重建，碼值不用存
+int write_full_header(FILE* fout, uint32_t original_size, const int lengths[256], const CodeEntry codes[256]) {
+    // 原始大小、碼長表的 byte 數都用 varint，小檔案只要 1~2 byte
+    unsigned char head[2 * VARINT_MAX];
+    unsigned char table[LENGTH_TABLE_MAX];
+    size_t table_len = put_length_table(lengths, table);
+    size_t n = put_varint(head, original_size);
+    n += put_varint(head + n, table_len);
+    if (fwrite(head, 1, n, fout) != n || fwrite(table, 1, table_len, fout) != table_len) {
         return -1;
     }
     printf("| Sym | Len | Code (Binary) | Code (Dec) |\n");
@@ -265,15 +196,11 @@ int write_full_header(FILE* fout, uint32_t original_size, const int lengths[256]
         if (lengths[i] > 0) {
             unsigned char s = (unsigned char)i;
             unsigned char L  = (unsigned char)lengths[i];
-            // 將二進位碼字串轉換為整數碼值
-            unsigned int code_value = code_to_uint(codes[i]);
-            printf("| 0x%02X | %3d | %-13s | %10u |\n", s, L, codes[i], code_value);
-            
-            // 寫入符號 (1 byte)
-            fwrite(&s, 1, 1, fout);
-            // 寫入長度 (1 byte)
-            fwrite(&L, 1, 1, fout);
-            fwrite(&code_value, sizeof(unsigned int), 1, fout);
+            // 碼值本來就是整數，字串只拿來印
+            unsigned int code_value = codes[i].code;
+            char code_str[HUFF_MAX_BITS + 1];
+            code_to_string(code_value, L, code_str);
+            printf("| 0x%02X | %3d | %-13s | %10u |\n", s, L, code_str, code_value);
         }
     }
     printf("----------------------------------------\n");
@@ -281,37 +208,16 @@ int write_full_header(FILE* fout, uint32_t original_size, const int lengths[256]
 }
 
 // 產生壓縮檔案
-void compress_file_bin(FILE* fin, FILE* fout, char codes[MAX_SYMBOLS][MAX_CODE_LEN], uint32_t original_size, int lengths[256], int limit_length) {
+void compress_file_bin(FILE* fin, FILE* fout, const CodeEntry codes[MAX_SYMBOLS], uint32_t original_size, int lengths[256], int limit_length) {
     uint8_t Lhdr = (limit_length > 0) ? (uint8_t)limit_length : 0;
     // 寫Header
     if ( write_full_header(fout, original_size, lengths, codes)  != 0) {
         fprintf(stderr, "write header failed\n");
         exit(1);
     }
-    // 寫 bitstream
+    // 寫 bitstream：整數碼值塞進 64-bit 累加器，一次寫出整個 word
     fseek(fin, 0, SEEK_SET);
-    unsigned char buffer = 0;
-    int bit_count = 0;
-    int c;
-    while ((c = fgetc(fin)) != EOF) { // 逐字去尋找CODE
-        const char* code = codes[(unsigned char)c];
-        for (int i = 0; code[i]; i++) {
-            buffer <<= 1;
-            if (code[i] == '1'){
-                buffer |= 1;
-            }
-            bit_count++;
-            if (bit_count == 8) {// 一個BTYE才可以寫入bin file
-                fputc(buffer, fout);
-                buffer = 0;
-                bit_count = 0;
-            }
-        }
-    }
-    if (bit_count > 0) {  // 不足八個則補0  ex: 110 -> 110 00000
-        buffer <<= (8 - bit_count);
-        fputc(buffer, fout);
-    }
+    encode_bitstream(fin, fout, codes);
 }
 
 // 進到壓縮模式
@@ -326,94 +232,54 @@ void compress(FILE* fin, FILE* fout, int limit_length){
     } 
 
     int lengths[MAX_SYMBOLS] = {0};
-    char codes[MAX_SYMBOLS][MAX_CODE_LEN];
-    for (int i = 0; i < MAX_SYMBOLS; i++){ // 初始化所有code
-       codes[i][0] = '\0'; 
-    } 
-    char code_buffer[MAX_CODE_LEN];
-    HuffmanNode* root = build_huffman_tree(freq);
-    calculate_code_lengths(root, 0, lengths);
-    int gen_mode = fix_code_lengths(lengths, limit_length, codes);
+    CodeEntry codes[MAX_SYMBOLS];
+    build_code_lengths(freq, lengths); // 由排序後的頻率直接算碼長，不建樹
+    int gen_mode = fix_code_lengths(freq, lengths, limit_length);
     printf("gen_mode: %d\n" , gen_mode);
     generate_limited_codes(lengths, codes);
     compress_file_bin(fin, fout, codes, original_size, lengths, limit_length);
-    free_tree(root);
 }
 
-// 讀取完整碼表並填充 CodeEntry 陣列
-int read_full_header_table(FILE* fbin, uint32_t* original_size, CodeEntry table[256]) {
-    // 讀取原始大小 (4 bytes)
-    if (fread(original_size, sizeof(uint32_t), 1, fbin) != 1) { 
-        return -1;
-    } 
-    // 讀取有效符號數量 (2 bytes)
-    uint16_t num = 0;
-    if (fread(&num, sizeof(uint16_t), 1, fbin) != 1) { 
-        return -2;
-    }
-
-    // 讀取符號、長度、碼值
-    for (uint16_t i = 0; i < num; i++) {
-        unsigned char sym, len;
-        unsigned int code_value;
-        
-        // 讀取符號 (1 byte)
-        if (fread(&sym, 1, 1, fbin) != 1) return -3;
-        
-        // 讀取長度 (1 byte)
-        if (fread(&len, 1, 1, fbin) != 1) return -4;
-        
-        // 讀取碼值 (4 bytes)
-        if (fread(&code_value, sizeof(unsigned int), 1, fbin) != 1) return -5;
-        
-        // 填充 CodeEntry 結構 去建立symbol code table
-        table[i].symbol = sym;
-        table[i].length = len;
-        table[i].code = code_value;
+// 讀取原始大小和碼長表
+int read_full_header_table(FILE* fbin, uint32_t* original_size, int lengths[256]) {
+    uint64_t size, table_len;
+    if (read_varint(fbin, &size) < 0 || size > UINT32_MAX) return -1;
+    if (read_varint(fbin, &table_len) < 0 || table_len > LENGTH_TABLE_MAX) return -2;
+    unsigned char table[LENGTH_TABLE_MAX];
+    if (fread(table, 1, (size_t)table_len, fbin) != table_len) return -3;
+    if (get_length_table(table, (size_t)table_len, lengths) < 0) return -4;
+    *original_size = (uint32_t)size;
+
+    int num = 0;
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] > 0) num++;
     }
-    return (int)num;
+    return num;
 }
 
 // 解壓縮檔案
 void decompress_file_bin(FILE* fin, FILE* fout) {
     uint32_t original_size = 0;
     
-    // 讀取完整碼表
-    CodeEntry table[MAX_SYMBOLS];
-    int num_symbols = read_full_header_table(fin, &original_size, table);
+    // 讀取碼長表：碼是 canonical，只要長度就能重建查表解碼器
+    int lengths[MAX_SYMBOLS] = {0};
+    int num_symbols = read_full_header_table(fin, &original_size, lengths);
     
     if (num_symbols < 0) {
         fprintf(stderr, "decode header error\n");
         return;
     }
-
-    // 逐位元解碼，直到寫滿 original_size(符合原本的長度)
-    uint32_t remain = original_size;
-    unsigned int bit_acc = 0;
-    int bit_count = 0;
-    int c;
-
-    while (remain > 0 && (c = fgetc(fin)) != EOF) {
-        unsigned char byte = (unsigned char)c;
-        for (int i = 7; i >= 0 && remain > 0; i--) {
-            int bit = (byte >> i) & 1;
-            bit_acc = (bit_acc << 1) | bit;
-            bit_count++;
-
-            // 嘗試匹配
-            for (int j = 0; j < num_symbols; j++) {
-                if (bit_count == table[j].length && bit_acc == table[j].code) {
-                    fputc(table[j].symbol, fout);
-                    bit_acc = 0;
-                    bit_count = 0;
-                    remain--;// 解到一個就扣，remain==0 立刻停(符合原本的長度)
-                    break;
-                }
-            }
-        }
+    DecodeTable dt;
+    if (build_decode_table(&dt, lengths) != 0) {
+        fprintf(stderr, "decode header error\n");
+        return;
     }
+
+    // 一次查表解出一個符號，直到寫滿 original_size(符合原本的長度)
+    uint64_t remain = decode_bitstream(fin, fout, &dt, original_size);
+    free_decode_table(&dt);
     if (remain != 0) {
-        fprintf(stderr, "ERROR: unexpected EOF, still need %u bytes\n", remain);
+        fprintf(stderr, "ERROR: unexpected EOF, still need %llu bytes\n", (unsigned long long)remain);
     }
 }
 
@@ -3,13 +3,12 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include "huff_core.h"
 
 // 定義可以執行的模式種類
 #define MODE_NONE 0
 #define MODE_C    1
 #define MODE_D    2
-#define MAX_SYMBOLS 256
-#define MAX_CODE_LEN 256
 #define MAX_PSEUDO 256
 
 
@@ -28,13 +27,6 @@ typedef struct {
     unsigned int code; // 用整數存 bit
 } HuffmanCodeEntry;
 
-//
-typedef struct {
-    unsigned int code;
-    unsigned char length;
-    unsigned char symbol;
-} CodeEntry;
-
 
 // 計算出現頻率
 int count_frequency(FILE* fin, int * fre_array){
@@ -42,9 +34,11 @@ int count_frequency(FILE* fin, int * fre_array){
         perror("Cannot open input.txt");
         return 1;
     }
-    int c;
-    while ((c = fgetc(fin)) != EOF) { // 一個字一個字讀取
-        fre_array[c]++;
+    // 一次讀一大塊再整塊統計
+    unsigned char buf[HUFF_IO_BUF];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fin)) > 0) {
+        count_block_frequency(buf, n, fre_array);
     }
 
     // 印出頻率
@@ -106,62 +100,48 @@ HuffmanNode* build_huffman_tree(int freq[MAX_SYMBOLS]) { //建立Huffman_tree
 }
 
 int write_header(FILE* fout, uint32_t original_size, uint8_t limit_L, const int lengths[256]) { // 寫入壓縮檔案 output.bin
-    
-    if (fwrite(&original_size, sizeof(uint32_t), 1, fout) != 1) { //寫入原始資料大小 original_size
+    // 原始大小 (varint) + 碼長表 byte 數 (varint) + 壓縮過的碼長表
+    unsigned char head[2 * VARINT_MAX];
+    unsigned char table[LENGTH_TABLE_MAX];
+    size_t table_len = put_length_table(lengths, table);
+    size_t n = put_varint(head, original_size);
+    n += put_varint(head + n, table_len);
+    if (fwrite(head, 1, n, fout) != n) {
         return -1;
     }
-    uint16_t num = 0;
-    for (int i = 0; i < 256; i++) {// 計算出所有碼字長度大於 0 的符號數量
-        if (lengths[i] > 0) {
-            num++;
-        }
-    }
-
-    if (fwrite(&num, sizeof(uint16_t), 1, fout) != 1) { // 將 num 寫入檔案
+    if (fwrite(table, 1, table_len, fout) != table_len) {
         return -1;
     }
-
-    for (int i = 0; i < 256; i++) { //寫入每個有效符號及其碼字長度
-        if (lengths[i] > 0) {
-            unsigned char s = (unsigned char)i;
-            unsigned char L  = (unsigned char)lengths[i];
-            if (fwrite(&s, 1, 1, fout) != 1) {
-                return -1;
-            }
-            if (fwrite(&L, 1, 1, fout) != 1) {
-                return -1;
-            } 
-        }
-    }
     return 0;
 }
 
 int read_header(FILE* fbin, uint32_t* original_size, uint8_t* limit_L, int lengths[256]) { // 讀取壓縮檔案 output.bin
-
-    if (fread(original_size, sizeof(uint32_t), 1, fbin) != 1) { // 讀取原始大小
+    uint64_t size, table_len;
+    if (read_varint(fbin, &size) < 0 || size > UINT32_MAX) { // 讀取原始大小
         return -1;
-    } 
-    uint16_t num = 0;
-    if (fread(&num, sizeof(uint16_t), 1, fbin) != 1) { // 讀取有效符號數量
+    }
+    if (read_varint(fbin, &table_len) < 0 || table_len > LENGTH_TABLE_MAX) { // 讀取碼長表大小
         return -2;
     }
-
+    unsigned char table[LENGTH_TABLE_MAX];
+    if (fread(table, 1, (size_t)table_len, fbin) != table_len) {
+        return -3;
+    }
     memset(lengths, 0, 256 * sizeof(int)); // 初始化長度陣列
-    for (uint16_t i = 0; i < num; i++) { // 讀取符號及其碼字長度
-        unsigned char sym, len;
-        if (fread(&sym, 1, 1, fbin) != 1){
-            return -3;
-        }
-        if (fread(&len, 1, 1, fbin) != 1){
-           return -4; 
-        } 
-        lengths[sym] = (int)len;
+    if (get_length_table(table, (size_t)table_len, lengths) < 0) {
+        return -4;
     }
-    return (int)num;
+    *original_size = (uint32_t)size;
+
+    int num = 0;
+    for (int i = 0; i < 256; i++) { // 計算有效符號數量
+        if (lengths[i] > 0) num++;
+    }
+    return num;
 }
 
 
-void compress_file_bin(FILE* fin, FILE* fout, char codes[MAX_SYMBOLS][MAX_CODE_LEN], uint32_t original_size, int lengths[256], int limit_length) {
+void compress_file_bin(FILE* fin, FILE* fout, const CodeEntry codes[MAX_SYMBOLS], uint32_t original_size, int lengths[256], int limit_length) {
     uint8_t Lhdr = (limit_length > 0) ? (uint8_t)limit_length : 0;
     // 寫Header
     if (write_header(fout, original_size, Lhdr, lengths) != 0) {
@@ -169,30 +149,9 @@ void compress_file_bin(FILE* fin, FILE* fout, char codes[MAX_SYMBOLS][MAX_CODE_L
         exit(1);
     }
 
-    // 寫 bitstream
+    // 寫 bitstream：整數碼值塞進 64-bit 累加器，一次寫出整個 word
     fseek(fin, 0, SEEK_SET);
-    unsigned char buffer = 0;
-    int bit_count = 0;
-    int c;
-    while ((c = fgetc(fin)) != EOF) {
-        const char* code = codes[(unsigned char)c];
-        for (int i = 0; code[i]; i++) {
-            buffer <<= 1;
-            if (code[i] == '1'){
-                buffer |= 1;
-            }
-            bit_count++;
-            if (bit_count == 8) {
-                fputc(buffer, fout);
-                buffer = 0;
-                bit_count = 0;
-            }
-        }
-    }
-    if (bit_count > 0) {
-        buffer <<= (8 - bit_count);
-        fputc(buffer, fout);
-    }
+    encode_bitstream(fin, fout, codes);
 }
 
 
@@ -227,50 +186,6 @@ void generate_codes(HuffmanNode* node, char* code, int depth, char codes[MAX_SYM
     }
 }
 
-void generate_limited_codes(int lengths[MAX_SYMBOLS], char codes[MAX_SYMBOLS][MAX_CODE_LEN]) {
-    // 確定最大碼字長度
-    int max_len = 0;
-    for (int i = 0; i < MAX_SYMBOLS; i++) { 
-        if (lengths[i] > max_len) {
-            max_len = lengths[i];
-        }
-    }
-        
-    // 計算每種長度的數量
-    int bl_count[MAX_CODE_LEN + 1] = {0};
-    for (int i = 0; i < MAX_SYMBOLS; i++){
-        if (lengths[i] > 0){
-            bl_count[lengths[i]]++;
-        }
-    }
-        
-    // 計算每個長度的起始碼值
-    int next_code[MAX_CODE_LEN + 1] = {0};
-    int code = 0;
-
-    // Canonical: 計算每個長度的起始 code
-    for (int len = 1; len <= max_len; len++) {
-        code = (code + bl_count[len-1]) << 1;
-        next_code[len] = code;
-    }
-
-    // 產生每個 symbol 的 code
-    for (int i = 0; i < MAX_SYMBOLS; i++) {
-        int len = lengths[i];
-        if (len == 0) {
-            codes[i][0] = '\0';
-            continue;
-        }
-
-        int c = next_code[len]++;
-
-        // 變成字串
-        for (int b = len - 1; b >= 0; b--)
-            codes[i][len - 1 - b] = ((c >> b) & 1) ? '1' : '0';
-
-        codes[i][len] = '\0';
-    }
-}
 // 釋放 Huffman Tree 記憶體
 void free_tree(HuffmanNode* node) {
     if (!node) return;
@@ -294,19 +209,18 @@ void calculate_code_lengths(HuffmanNode* node, int depth, int lengths[MAX_SYMBOL
 
 // 只針對「出現過的符號」(lengths[i] > 0) 做事
 // 只在超過 limit_length 時才套用長度限制
-// 將每個符號的長度都改成 limit_length
-// 否則不更動
-int fix_code_lengths(int lengths[MAX_SYMBOLS], int limit_length, char codes[MAX_SYMBOLS][MAX_CODE_LEN]) {
-    if (limit_length <= 0) { // 沒有限制，直接用原碼長
-        return 0; 
+// 用 package-merge 重新分配碼長，常用的符號仍然保持短碼
+// 否則不更動 (沒有限制時也不能超過解碼器上限 HUFF_MAX_BITS)
+int fix_code_lengths(const int freq[MAX_SYMBOLS], int lengths[MAX_SYMBOLS], int limit_length) {
+    if (limit_length <= 0 || limit_length > HUFF_MAX_BITS) { // 沒有限制，用解碼器上限
+        limit_length = HUFF_MAX_BITS;
     }
-    int present[MAX_SYMBOLS];
     int k = 0, max_len = 0;
 
     // 蒐集「真的出現過」的符號，並找原本的最大碼長
     for (int i = 0; i < MAX_SYMBOLS; i++) {
         if (lengths[i] > 0) {
-            present[k++] = i;
+            k++;
             if (lengths[i] > max_len) max_len = lengths[i];
         }
     }
@@ -321,11 +235,9 @@ int fix_code_lengths(int lengths[MAX_SYMBOLS], int limit_length, char codes[MAX_
             exit(1);
         }
 
-        // 將每個 code 全部設為 L，確保可解
-        for (int i = 0; i < k; i++) {
-            lengths[present[i]] = limit_length;
-        }
-        return 1;     // 沒超過限制：完全不更動
+        // 在不超過 L 的條件下求最佳碼長
+        limit_code_lengths(freq, lengths, limit_length);
+        return 1;
     }
 }
 
@@ -346,15 +258,9 @@ void compress(FILE* fin, FILE* fout, int limit_length){
     } 
 
     int lengths[MAX_SYMBOLS] = {0};
-    char codes[MAX_SYMBOLS][MAX_CODE_LEN];
-
-    for (int i = 0; i < MAX_SYMBOLS; i++){ // 初始化
-       codes[i][0] = '\0'; 
-    } 
-    char code_buffer[MAX_CODE_LEN];
-    HuffmanNode* root = build_huffman_tree(freq);
-    calculate_code_lengths(root, 0, lengths);
-    int gen_mode = fix_code_lengths(lengths, limit_length, codes);
+    CodeEntry codes[MAX_SYMBOLS];
+    build_code_lengths(freq, lengths); // 由排序後的頻率直接算碼長，不建樹
+    int gen_mode = fix_code_lengths(freq, lengths, limit_length);
     printf("gen_mode: %d\n" , gen_mode);
     if(gen_mode == 1){ // 0 == no limit
         // generate_codes(root, code_buffer, 0, codes);
@@ -364,20 +270,17 @@ void compress(FILE* fin, FILE* fout, int limit_length){
         generate_limited_codes(lengths, codes);
     }
     compress_file_bin(fin, fout, codes, original_size, lengths, limit_length);
-    free_tree(root);
 }
 
 
 
 
 
-// 由 lengths 依 canonical 規則重建 bit pattern（用你現有的 generate_limited_codes）
 // 由 lengths 依 canonical 規則重建 bit pattern，並印出碼表
 static void build_codes_from_lengths(const int lengths[256], CodeEntry table[256], int* out_n) {
-    char codes[256][MAX_CODE_LEN];
-    for (int i = 0; i < 256; i++) codes[i][0] = '\0';
-    // 步驟 1: 生成規範霍夫曼碼字串
-    generate_limited_codes((int*)lengths, codes);
+    CodeEntry codes[256];
+    // 步驟 1: 生成規範霍夫曼碼值
+    generate_limited_codes(lengths, codes);
 
     int n = 0;
     
@@ -389,12 +292,11 @@ static void build_codes_from_lengths(const int lengths[256], CodeEntry table[256
     // 步驟 2: 遍歷所有符號，組裝 CodeEntry 並輸出
     for (int s = 0; s < 256; s++) {
         if (lengths[s] > 0) {
-            unsigned acc = 0;
+            unsigned acc = codes[s].code;
             
-            // 步驟 2a: 將二進位碼字串轉換為整數 (acc)
-            for (int k = 0; codes[s][k]; k++) {
-                acc = (acc << 1) | (codes[s][k] == '1');
-            }
+            // 步驟 2a: 將整數碼值轉成二進位字串 (只拿來印)
+            char code_str[HUFF_MAX_BITS + 1];
+            code_to_string(acc, lengths[s], code_str);
             
             // 步驟 2b: 組裝 CodeEntry 結構
             table[n].symbol = (unsigned char)s;
@@ -411,7 +313,7 @@ static void build_codes_from_lengths(const int lengths[256], CodeEntry table[256
             printf(" %6d |", lengths[s]);
 
             // 輸出二進位碼字串
-            printf(" %-25s |", codes[s]); 
+            printf(" %-25s |", code_str); 
             
             // 輸出碼值 (十進位)
             printf(" %10u |\n", acc); 
@@ -436,49 +338,24 @@ void decompress_file_bin(FILE* fin, FILE* fout) {
         return;
     }
 
-    // 用 lengths 重建 canonical codes
+    // 印出 canonical 碼表
     CodeEntry table[MAX_SYMBOLS];
     build_codes_from_lengths(lengths, table, &num_symbols);
 
-    // 逐位元解碼，直到寫滿 original_size
-    uint32_t remain = original_size;
-    unsigned int bit_acc = 0;
-    int bit_count = 0;
-    int c;
-
-    while (remain > 0 && (c = fgetc(fin)) != EOF) {
-        unsigned char byte = (unsigned char)c;
-
-        // （可選）debug：看讀到的 byte
-        // printf("byte: dec=%3d hex=0x%02X bin=", byte, byte);
-        // for (int k = 7; k >= 0; k--) printf("%d", (byte >> k) & 1);
-        // printf("\n");
-
-        for (int i = 7; i >= 0 && remain > 0; i--) {
-            int bit = (byte >> i) & 1;
-            bit_acc = (bit_acc << 1) | bit;
-            bit_count++;
-
-            // （可選）debug：看現在 bit_acc（bit_count 位）
-            // printf("bit_acc (%2d bits) = ", bit_count);
-            // for (int k = bit_count - 1; k >= 0; k--) printf("%d", (bit_acc >> k) & 1);
-            // printf("\n");
-
-            // 嘗試匹配
-            for (int j = 0; j < num_symbols; j++) {
-                if (bit_count == table[j].length && bit_acc == table[j].code) {
-                    fputc(table[j].symbol, fout);
-                    bit_acc = 0;
-                    bit_count = 0;
-                    remain--;              // ✅ 解到一個就扣，remain==0 立刻停
-                    break;
-                }
-            }
-        }
+
+    // 用 lengths 建立查表解碼器
+    DecodeTable dt;
+    if (build_decode_table(&dt, lengths) != 0) {
+        fprintf(stderr, "decode header error\n");
+        return;
     }
 
+    // 一次查表解出一個符號，直到寫滿 original_size
+    uint64_t remain = decode_bitstream(fin, fout, &dt, original_size);
+    free_decode_table(&dt);
+
     if (remain != 0) {
-        fprintf(stderr, "ERROR: unexpected EOF, still need %u bytes\n", remain);
+        fprintf(stderr, "ERROR: unexpected EOF, still need %llu bytes\n", (unsigned long long)remain);
     }
 }
 
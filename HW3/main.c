@@ -3,13 +3,26 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include "huff_core.h"
+#include "huff_block.h"
+#include "huff_parallel.h"
+#include "huff_mmap.h"
+#include "huff_adaptive.h"
+#include "huff_stats.h"
+#include "huff_lz77.h"
+#include "huff_dict.h"
 
 // 定義可以執行的模式種類
 #define MODE_NONE 0
 #define MODE_C    1
 #define MODE_D    2
-#define MAX_SYMBOLS 256
-#define MAX_CODE_LEN 256
+#define MODE_T    3   // 從樣本訓練字典
 #define MAX_PSEUDO 256
 
 
@@ -36,21 +49,29 @@ typedef struct {
 PseudoSymbol pseudo[MAX_PSEUDO]; // pseudo-symbol 映射表
 int pseudo_count = 0;
 
-// 計算出現頻率
-int count_frequency(FILE* fin, int * fre_array){
-    if (!fin) {
-        perror("Cannot open input.txt");
-        return 1;
-    }
-    int c;
-    while ((c = fgetc(fin)) != EOF) { // 一個字一個字讀取
-        fre_array[c]++;
+// 壓縮中的輸出檔：失敗時要刪掉 (stdout 的話 path 是 NULL，只能靠結束碼)
+static FILE* output_fp = NULL;
+static const char* output_path = NULL;
+
+// 壓縮失敗：輸出檔可能已經有一個看起來正常的檔頭，刪掉免得被當成壓好的檔案
+static void compress_abort(void) {
+    if (output_path) {
+        fclose(output_fp);
+        remove(output_path);
     }
+    exit(1);
+}
+
+// 計算一個 block 的出現頻率，verbose 時印出來
+int count_frequency(const unsigned char* buf, size_t n, int * fre_array, int verbose){
+    count_block_frequency(buf, n, fre_array);
 
     // 印出頻率
-    for (int i = 0; i < 256; i++) {
-        if (fre_array[i] > 0) {
-            printf("Char 0x%02X ('%c') : %d\n", i, (i >= 32 && i <= 126) ? i : '.', fre_array[i]);
+    if (verbose) {
+        for (int i = 0; i < 256; i++) {
+            if (fre_array[i] > 0) {
+                printf("Char 0x%02X ('%c') : %d\n", i, (i >= 32 && i <= 126) ? i : '.', fre_array[i]);
+            }
         }
     }
     return 0;
@@ -133,59 +154,17 @@ void display_huffman_tree(HuffmanNode* node, int level) {
     // 左子節點
     display_huffman_tree(node->left, level + 1);
 }
-// ---------------- Write Compressed File ----------------
-// ===== Header: "HUF1" + original_size + L + num_symbols + (symbol, length)*n =====
-static int write_header(FILE* fo, uint32_t original_size, uint8_t limit_L, const int lengths[256]) {
-    if (fwrite("HUF1", 1, 4, fo) != 4) return -1;
-    if (fwrite(&original_size, sizeof(uint32_t), 1, fo) != 1) return -1;
-    if (fwrite(&limit_L, 1, 1, fo) != 1) return -1;
-
-    uint16_t num = 0;
-    for (int i = 0; i < 256; i++) if (lengths[i] > 0) num++;
-    if (fwrite(&num, sizeof(uint16_t), 1, fo) != 1) return -1;
-
-    for (int i = 0; i < 256; i++) {
-        if (lengths[i] > 0) {
-            unsigned char s = (unsigned char)i;
-            unsigned char L  = (unsigned char)lengths[i];
-            if (fwrite(&s, 1, 1, fo) != 1) return -1;
-            if (fwrite(&L, 1, 1, fo) != 1) return -1;
-        }
-    }
-    return 0;
-}
-
-
-void compress_file_bin(FILE* fin, FILE* fout, char codes[MAX_SYMBOLS][MAX_CODE_LEN],
-                       uint32_t original_size, int lengths[256], int limit_length) {
-    uint8_t Lhdr = (limit_length > 0) ? (uint8_t)limit_length : 0;
-    if (write_header(fout, original_size, Lhdr, lengths) != 0) {
-        fprintf(stderr, "write header failed\n");
-        exit(1);
-    }
-
-    // 寫 bitstream（沿用你原本的 byte 緩衝）
-    fseek(fin, 0, SEEK_SET);
-    unsigned char buffer = 0;
-    int bit_count = 0;
-    int c;
-    while ((c = fgetc(fin)) != EOF) {
-        const char* code = codes[(unsigned char)c];
-        for (int i = 0; code[i]; i++) {
-            buffer <<= 1;
-            if (code[i] == '1') buffer |= 1;
-            bit_count++;
-            if (bit_count == 8) {
-                fputc(buffer, fout);
-                buffer = 0;
-                bit_count = 0;
-            }
-        }
-    }
-    if (bit_count > 0) {
-        buffer <<= (8 - bit_count);
-        fputc(buffer, fout);
-    }
+// 取得檔案大小 (超過 4GB 也可以)，讀寫位置會回到開頭
+// 一般檔案直接問檔案系統拿大小 (不用 seek)；pipe 之類拿不到就是 HUF2_SIZE_UNKNOWN
+static uint64_t input_size(FILE* fp) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_fstat64(_fileno(fp), &st) != 0 || !(st.st_mode & _S_IFREG)) return HUF2_SIZE_UNKNOWN;
+#else
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) return HUF2_SIZE_UNKNOWN;
+#endif
+    return (uint64_t)st.st_size;
 }
 
 
@@ -228,111 +207,139 @@ void calculate_code_lengths(HuffmanNode* node, int depth, int lengths[MAX_SYMBOL
     if (node->right) calculate_code_lengths(node->right, depth + 1, lengths);
 }
 
-// 取代原本的 fix_code_lengths（簡單、穩定、合法）
-// 規則：只針對「出現過的符號」(lengths[i] > 0) 做事；
-// 只在超過 limit_L 時才套用長度限制；否則不更動
-void fix_code_lengths(int lengths[MAX_SYMBOLS], int limit_L) {
-    if (limit_L <= 0) return;   // 沒有限制，直接用原碼長
-
-    int present[MAX_SYMBOLS];
-    int k = 0, max_len = 0;
+// -v：印出這個 block 的頻率表和 Huffman tree (只有要顯示時才真的建樹)
+static void show_block_tree(const unsigned char* in, size_t n) {
+    int freq[MAX_SYMBOLS] = {0};
+    count_frequency(in, n, freq, 1);
+    HuffmanNode* root = build_huffman_tree(freq);
+    display_huffman_tree(root, 0);
+    free_tree(root);
+}
 
-    // 蒐集「真的出現過」的符號，並找原本的最大碼長
+// 碼長限制太小，裝不下 block 裡所有符號
+static void limit_error(const unsigned char* in, size_t n, int limit_L) {
+    int freq[MAX_SYMBOLS] = {0};
+    int k = 0;
+    count_block_frequency(in, n, freq);
     for (int i = 0; i < MAX_SYMBOLS; i++) {
-        if (lengths[i] > 0) {
-            present[k++] = i;
-            if (lengths[i] > max_len) max_len = lengths[i];
-        }
-    }
-    if (k == 0) return;                 // 空檔案之類，不處理
-    if (max_len <= limit_L) return;     // ✅ 沒超過限制：完全不更動
-
-    // 底下這段只在「真的超過」時才執行
-    if (limit_L < 31 && k > (1 << limit_L)) {
-        fprintf(stderr, "Error: L=%d CAN'T ENCODE %d SYMBOLS NEED L >= ceil(log2(%d)\n",
-                limit_L, k, k);
-        exit(1);
-    }
-
-    // 最簡、穩定的保底作法：全部設為 L（一定滿足 Kraft，確保可解）
-    for (int i = 0; i < k; i++) {
-        lengths[present[i]] = limit_L;
+        if (freq[i] > 0) k++;
     }
+    fprintf(stderr, "Error: L=%d CAN'T ENCODE %d SYMBOLS NEED L >= ceil(log2(%d)\n", limit_L, k, k);
+    compress_abort();
 }
 
+// ===== HUF2：檔頭 + 每個 block (block 頭 + 碼長表 + bitstream) + 結束 block =====
+// 輸入只往前讀一次，一次只放一個 block 在記憶體 (可以接 pipe)
+// src 不是 NULL 時 block 直接從輸入映射切出來
+void compress_file_bin(FILE* fin, FILE* fout, uint64_t original_size, const BlockOptions* opt,
+                       uint32_t block_size, int threads, int show_tree, const MappedFile* src) {
+    int limit_length = opt->limit_L;
+    HuffStats* st = opt->stats;
+    ContainerHeader ch;
+    ch.version = HUF2_VERSION;
+    ch.flags = 0;
+    if (original_size == HUF2_SIZE_UNKNOWN) ch.flags |= HUF2_FLAG_STREAM;
+    // 只有一個 block 時索引沒有用處，小檔案就省下這段
+    if (original_size == HUF2_SIZE_UNKNOWN || original_size > block_size) ch.flags |= HUF2_FLAG_INDEX;
+    ch.limit_L = (limit_length > 0) ? (uint8_t)limit_length : 0;
+    ch.block_size = block_size;
+    ch.original_size = original_size;
+
+    unsigned char hdr[HUF2_HEADER_MAX];
+    size_t hdr_len = put_container_header(hdr, &ch);
+    if (fwrite(hdr, 1, hdr_len, fout) != hdr_len) {
+        fprintf(stderr, "write header failed\n");
+        compress_abort();
+    }
 
+    // 邊寫邊記每個 block 的位置，最後附在檔尾給平行解壓用
+    BlockIndex idx;
+    index_init(&idx, ch.header_size);
 
-
-void generate_limited_codes(int lengths[MAX_SYMBOLS],char codes[MAX_SYMBOLS][MAX_CODE_LEN])
-{
-    int max_len = 0;
-    for (int i = 0; i < MAX_SYMBOLS; i++)
-        if (lengths[i] > max_len)
-            max_len = lengths[i];
-
-    // 計算每種長度的數量
-    int bl_count[MAX_CODE_LEN + 1] = {0};
-    for (int i = 0; i < MAX_SYMBOLS; i++)
-        if (lengths[i] > 0)
-            bl_count[lengths[i]]++;
-
-    int next_code[MAX_CODE_LEN + 1] = {0};
-    int code = 0;
-
-    // Canonical: 計算每個長度的起始 code
-    for (int len = 1; len <= max_len; len++) {
-        code = (code + bl_count[len-1]) << 1;
-        next_code[len] = code;
+    // 不只一個 block 時用 pipeline：reader / coder / writer 各一條 thread，讀、壓、寫同時進行
+    // 多條 coder 各自壓 block，依原本順序寫出；開不了 thread 就在這條 thread 上依序做
+    int rc = PAR_ERR_MEM;
+    if (!show_tree && (threads > 1 || original_size == HUF2_SIZE_UNKNOWN || original_size > block_size)) {
+        rc = compress_blocks_parallel(fin, fout, opt, block_size, threads, &idx, src);
     }
-
-    // 產生每個 symbol 的 code
-    for (int i = 0; i < MAX_SYMBOLS; i++) {
-        int len = lengths[i];
-        if (len == 0) {
-            codes[i][0] = '\0';
-            continue;
+    if (rc == PAR_ERR_LIMIT) {
+        fprintf(stderr, "Error: L=%d CAN'T ENCODE ALL SYMBOLS OF A BLOCK\n", limit_length);
+        compress_abort();
+    }
+    if (rc != PAR_OK && rc != PAR_ERR_MEM) {
+        fprintf(stderr, "write block failed\n");
+        compress_abort();
+    }
+    if (rc == PAR_ERR_MEM) {
+        unsigned char* buf = src ? NULL : (unsigned char*)malloc(block_size);
+        unsigned char* out = (unsigned char*)malloc(block_bound(block_size));
+        if ((!src && !buf) || !out) {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            compress_abort();
         }
 
-        int c = next_code[len]++;
-
-        // 變成字串
-        for (int b = len - 1; b >= 0; b--)
-            codes[i][len - 1 - b] = ((c >> b) & 1) ? '1' : '0';
+        // 一次拿一個 block，各自統計、各自建表
+        const unsigned char* in = buf;
+        uint64_t src_pos = 0;
+        size_t n;
+        for (;;) {
+            if (src) {
+                n = src->size - src_pos < block_size ? (size_t)(src->size - src_pos) : block_size;
+                in = src->data + src_pos;
+                src_pos += n;
+            }
+            else {
+                double t = st ? stats_now() : 0.0;
+                n = fread(buf, 1, block_size, fin);
+                if (st) stats_lap(st, STAT_READ, t);
+            }
+            if (n == 0) break;
+            if (show_tree) show_block_tree(in, n);
+            size_t m = compress_block(in, n, opt, out);
+            if (m == 0) limit_error(in, n, limit_length);
+            double t = st ? stats_now() : 0.0;
+            if (fwrite(out, 1, m, fout) != m || index_add(&idx, (uint32_t)n, (uint32_t)m) != 0) {
+                fprintf(stderr, "write block failed\n");
+                compress_abort();
+            }
+            if (st) stats_lap(st, STAT_WRITE, t);
+        }
+        free(buf);
+        free(out);
+    }
 
-        codes[i][len] = '\0';
+    // 結束 block
+    BlockHeader end = { BLOCK_END, 0, 0 };
+    size_t end_len = put_block_header(hdr, &end);
+    if (fwrite(hdr, 1, end_len, fout) != end_len ||
+        ((ch.flags & HUF2_FLAG_INDEX) && index_write(fout, &idx, idx.comp_pos + end_len) != 0)) {
+        fprintf(stderr, "write block failed\n");
+        compress_abort();
+    }
+    if (original_size != HUF2_SIZE_UNKNOWN && idx.raw_pos != original_size) {
+        fprintf(stderr, "Error: input size changed while compressing\n");
+        compress_abort();
     }
+    if (st) {
+        st->format = HUF2_MAGIC;
+        st->bytes_in = idx.raw_pos;
+        st->bytes_out = idx.comp_pos + end_len;
+        if (ch.flags & HUF2_FLAG_INDEX) st->bytes_out += idx.count * INDEX_ENTRY_SIZE + INDEX_FOOTER_SIZE;
+    }
+    index_free(&idx);
 }
 
-void compress(FILE* fin, FILE* fout, int limit_length){
-    int freq[MAX_SYMBOLS] = {0};
-    count_frequency(fin, freq);
-
-    // 算原始長度（直接把 freq 加總）
-    uint32_t original_size = 0;
-    for (int i = 0; i < MAX_SYMBOLS; i++) original_size += (uint32_t)freq[i];
-
-    HuffmanNode* root = build_huffman_tree(freq);
-
-    int lengths[MAX_SYMBOLS] = {0};
-    calculate_code_lengths(root, 0, lengths);
-    fix_code_lengths(lengths, limit_length);
-
-    char codes[MAX_SYMBOLS][MAX_CODE_LEN];
-    for (int i = 0; i < MAX_SYMBOLS; i++) codes[i][0] = '\0';
-    generate_limited_codes(lengths, codes);
-
-    // ✅ 新版：帶 original_size + lengths
-    compress_file_bin(fin, fout, codes, original_size, lengths, limit_length);
-    free_tree(root);
+void compress(FILE* fin, FILE* fout, const BlockOptions* opt, uint32_t block_size, int threads, int show_tree){
+    uint64_t original_size = input_size(fin);
+    // 一般檔案整個映射進來，省掉 fread 複製到 block buffer；映射不了 (pipe 等) 就照舊用 fread
+    MappedFile src;
+    int mapped = map_input(fin, &src) == 0;
+    compress_file_bin(fin, fout, original_size, opt, block_size, threads, show_tree,
+                      mapped ? &src : NULL);
+    if (mapped) unmap_file(&src, NULL, 0);
 }
 
 
-typedef struct {
-    unsigned int code;
-    unsigned char length;
-    unsigned char symbol;
-} CodeEntry;
-
 int read_huffman_table(FILE* fin, CodeEntry table[MAX_SYMBOLS]) {
     int num_symbols = fgetc(fin);
     for (int i = 0; i < num_symbols; i++) {
@@ -365,10 +372,8 @@ void print_huffman_table(CodeEntry table[MAX_SYMBOLS], int num_symbols) {
         printf("\n");
     }
 }
+// 舊版 HUF1 的檔頭 (magic 已經讀掉了)
 static int read_header(FILE* fi, uint32_t* original_size, uint8_t* limit_L, int lengths[256]) {
-    char magic[4];
-    if (fread(magic, 1, 4, fi) != 4) return -1;
-    if (memcmp(magic, "HUF1", 4) != 0) return -2;
     if (fread(original_size, sizeof(uint32_t), 1, fi) != 1) return -3;
     if (fread(limit_L, 1, 1, fi) != 1) return -4;
     uint16_t num = 0;
@@ -384,87 +389,404 @@ static int read_header(FILE* fi, uint32_t* original_size, uint8_t* limit_L, int
     return (int)num;
 }
 
-// 由 lengths 依 canonical 規則重建 bit pattern（用你現有的 generate_limited_codes）
-static void build_codes_from_lengths(const int lengths[256], CodeEntry table[256], int* out_n) {
-    char codes[256][MAX_CODE_LEN];
-    for (int i = 0; i < 256; i++) codes[i][0] = '\0';
-    generate_limited_codes((int*)lengths, codes);
-
-    int n = 0;
-    for (int s = 0; s < 256; s++) {
-        if (lengths[s] > 0) {
-            unsigned acc = 0;
-            for (int k = 0; codes[s][k]; k++) {
-                acc = (acc << 1) | (codes[s][k] == '1');
-            }
-            table[n].symbol = (unsigned char)s;
-            table[n].length = (unsigned char)lengths[s];
-            table[n].code   = acc;
-            n++;
-        }
-    }
-    *out_n = n;
-}
-
-
-void decompress_file_bin(FILE* fin, FILE* fout) {
-    // 讀 Header
+// 舊版 HUF1：整個檔案一張表、一條 bitstream；成功回傳 0
+static int decompress_huf1(FILE* fin, FILE* fout, HuffStats* st) {
     uint32_t original_size = 0;
     uint8_t  limitL = 0;
     int lengths[MAX_SYMBOLS] = {0};
     int num_symbols = read_header(fin, &original_size, &limitL, lengths);
     if (num_symbols < 0) {
         fprintf(stderr, "decode header error\n");
-        return;
+        return -1;
     }
 
-    // 用 lengths 重建 canonical codes
-    CodeEntry table[MAX_SYMBOLS];
-    build_codes_from_lengths(lengths, table, &num_symbols);
-
-    // 逐位元解碼，直到寫滿 original_size
-    uint32_t remain = original_size;
-    unsigned int bit_acc = 0;
-    int bit_count = 0;
-    int c;
-
-    while (remain > 0 && (c = fgetc(fin)) != EOF) {
-        unsigned char byte = (unsigned char)c;
-
-        // （可選）debug：看讀到的 byte
-        // printf("byte: dec=%3d hex=0x%02X bin=", byte, byte);
-        // for (int k = 7; k >= 0; k--) printf("%d", (byte >> k) & 1);
-        // printf("\n");
-
-        for (int i = 7; i >= 0 && remain > 0; i--) {
-            int bit = (byte >> i) & 1;
-            bit_acc = (bit_acc << 1) | bit;
-            bit_count++;
-
-            // （可選）debug：看現在 bit_acc（bit_count 位）
-            // printf("bit_acc (%2d bits) = ", bit_count);
-            // for (int k = bit_count - 1; k >= 0; k--) printf("%d", (bit_acc >> k) & 1);
-            // printf("\n");
-
-            // 嘗試匹配
-            for (int j = 0; j < num_symbols; j++) {
-                if (bit_count == table[j].length && bit_acc == table[j].code) {
-                    fputc(table[j].symbol, fout);
-                    bit_acc = 0;
-                    bit_count = 0;
-                    remain--;              // ✅ 解到一個就扣，remain==0 立刻停
-                    break;
-                }
+    // 用 lengths 建立查表解碼器
+    double t = st ? stats_now() : 0.0;
+    DecodeTable dt;
+    if (build_decode_table(&dt, lengths) != 0) {
+        fprintf(stderr, "decode header error\n");
+        return -1;
+    }
+    build_multi_table(&dt);
+    if (st) {
+        t = stats_lap(st, STAT_TABLE, t);
+        st->blocks = 1;
+        st->decode_table_bytes = (size_t)dt.num_entries * sizeof(DecodeEntry) + (size_t)dt.num_subs * sizeof(uint32_t);
+        if (dt.multi) st->decode_table_bytes += sizeof(MultiEntry) << MULTI_LOOKUP_BITS;
+    }
+
+    // 一次查表解出一個符號，直到寫滿 original_size (讀寫都在裡面，一起算進 decode)
+    uint64_t remain = decode_bitstream(fin, fout, &dt, original_size);
+    free_decode_table(&dt);
+    if (st) stats_lap(st, STAT_DECODE, t);
+
+    if (remain != 0) {
+        fprintf(stderr, "ERROR: unexpected EOF, still need %llu bytes\n", (unsigned long long)remain);
+        return -1;
+    }
+    return 0;
+}
+
+// 從輸入映射或 fread 拿接下來 n byte；不夠回傳 NULL
+static const unsigned char* next_bytes(FILE* fin, const MappedFile* src, uint64_t* pos,
+                                       unsigned char* buf, size_t n) {
+    if (src) {
+        if (src->size - *pos < n) return NULL;
+        const unsigned char* p = src->data + *pos;
+        *pos += n;
+        return p;
+    }
+    return fread(buf, 1, n, fin) == n ? buf : NULL;
+}
+
+// 解到結束 block (ok) 而且長度對得上才算成功，否則印出錯誤回傳 -1
+static int check_huf2_end(const ContainerHeader* ch, int ok, uint64_t written) {
+    if (ch->original_size == HUF2_SIZE_UNKNOWN) {
+        if (!ok) fprintf(stderr, "ERROR: unexpected EOF after %llu bytes\n", (unsigned long long)written);
+        return ok ? 0 : -1;
+    }
+    if (!ok || written != ch->original_size) {
+        uint64_t remain = ch->original_size > written ? ch->original_size - written : 0;
+        fprintf(stderr, "ERROR: unexpected EOF, still need %llu bytes\n", (unsigned long long)remain);
+        return -1;
+    }
+    return 0;
+}
+
+// HUF2 依序解 (單一 thread)：只往前讀，不需要索引；*written 是解出的 byte 數，讀到結束 block 回傳 1
+static int decompress_huf2_serial(FILE* fin, FILE* fout, const ContainerHeader* ch,
+                                  const MappedFile* src, MappedFile* dst, HuffStats* st, uint64_t* written_out) {
+    unsigned char* payload_buf = src ? NULL : (unsigned char*)malloc(block_bound(ch->block_size));
+    unsigned char* out_buf = dst ? NULL : (unsigned char*)malloc(ch->block_size);
+    if ((!src && !payload_buf) || (!dst && !out_buf)) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(1);
+    }
+
+    // 一個 block 一個 block 解，每個 block 用自己的碼長表 (解碼表的空間沿用)
+    DecodeTable dt;
+    memset(&dt, 0, sizeof(dt));
+    uint64_t pos = ch->header_size;
+    uint64_t written = 0;
+    int ok = 0;
+    for (;;) {
+        BlockHeader bh;
+        double t = st ? stats_now() : 0.0;
+        if (src) {
+            int h = get_block_header(src->data + pos, src->size - pos, &bh);
+            if (h < 0) break;
+            pos += (uint64_t)h;
+        }
+        else if (read_block_header(fin, &bh) < 0) {
+            break;
+        }
+        if (bh.type == BLOCK_END) {
+            ok = 1;
+            break;
+        }
+        if (bh.raw_size > ch->block_size || bh.comp_size > block_bound(ch->block_size) ||
+            (dst && bh.raw_size > dst->size - written)) {
+            fprintf(stderr, "ERROR: corrupt block header\n");
+            break;
+        }
+        const unsigned char* payload = next_bytes(fin, src, &pos, payload_buf, bh.comp_size);
+        if (!payload) break;
+        if (st) stats_lap(st, STAT_READ, t);
+        if (bh.type == BLOCK_STORED && !dst && bh.comp_size == bh.raw_size) {
+            // 原始資料：不用先複製到 out_buf，直接從讀進來的地方寫出去
+            t = st ? stats_now() : 0.0;
+            fwrite(payload, 1, bh.raw_size, fout);
+            if (st) {
+                stats_lap(st, STAT_WRITE, t);
+                st->blocks++;
             }
+            written += bh.raw_size;
+            continue;
         }
+        unsigned char* out = dst ? dst->data + written : out_buf;
+        if (decode_block_with(&bh, payload, out, &dt, st) != 0) {
+            fprintf(stderr, "ERROR: corrupt block at offset %llu\n", (unsigned long long)written);
+            break;
+        }
+        if (!dst) {
+            t = st ? stats_now() : 0.0;
+            fwrite(out, 1, bh.raw_size, fout);
+            if (st) stats_lap(st, STAT_WRITE, t);
+        }
+        written += bh.raw_size;
     }
+    free(payload_buf);
+    free(out_buf);
+    free_decode_table(&dt);
+    *written_out = written;
+    return ok;
+}
 
-    if (remain != 0) {
-        fprintf(stderr, "ERROR: unexpected EOF, still need %u bytes\n", remain);
+// HUF2 依序解：只往前讀，不需要索引；成功回傳 0
+// src / dst 有映射時直接在映射上讀寫 (dst 大小就是 original_size)
+// 有 fread / fwrite 要等 (pipe、沒映射的檔) 或是要多條 thread 時用 pipeline，讀、解、寫同時進行
+static int decompress_huf2(FILE* fin, FILE* fout, const ContainerHeader* ch,
+                           const MappedFile* src, MappedFile* dst, int threads, HuffStats* st) {
+    uint64_t written = 0;
+    int ok = 0;
+    int rc = PAR_ERR_MEM;
+    if ((threads > 1 || !src || !dst) &&
+        (ch->original_size == HUF2_SIZE_UNKNOWN || ch->original_size > ch->block_size)) {
+        rc = decompress_pipeline(fin, fout, ch, threads, src, dst, st, &written);
     }
+    if (rc == PAR_ERR_MEM) ok = decompress_huf2_serial(fin, fout, ch, src, dst, st, &written);
+    else if (rc == PAR_OK) ok = 1;
+    else if (rc == PAR_ERR_DATA) fprintf(stderr, "ERROR: corrupt block at offset %llu\n", (unsigned long long)written);
+    else if (rc == PAR_ERR_IO) fprintf(stderr, "ERROR: write failed at offset %llu\n", (unsigned long long)written);
+
+    if (st) st->bytes_out = written;
+    // 壞掉的話輸出檔只留真的解出來的部分
+    if (dst) unmap_file(dst, fout, written);
+    return check_huf2_end(ch, ok, written);
 }
 
+// 第 1 版的 HUF2：固定長度的 block 頭、bitmap 碼長表；只用 fread / fwrite 照順序解，成功回傳 0
+static int decompress_huf2_v1(FILE* fin, FILE* fout, const ContainerHeader* ch, HuffStats* st) {
+    unsigned char* payload = (unsigned char*)malloc(block_bound(ch->block_size));
+    unsigned char* out = (unsigned char*)malloc(ch->block_size);
+    if (!payload || !out) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        exit(1);
+    }
 
+    uint64_t written = 0;
+    int ok = 0;
+    for (;;) {
+        BlockHeader bh;
+        if (read_block_header_v1(fin, &bh) < 0) break;
+        if (bh.type == BLOCK_END) {
+            ok = 1;
+            break;
+        }
+        if (bh.raw_size > ch->block_size || bh.comp_size > block_bound(ch->block_size)) {
+            fprintf(stderr, "ERROR: corrupt block header\n");
+            break;
+        }
+        if (fread(payload, 1, bh.comp_size, fin) != bh.comp_size) break;
+        if (decode_block_v1(&bh, payload, out) != 0) {
+            fprintf(stderr, "ERROR: corrupt block at offset %llu\n", (unsigned long long)written);
+            break;
+        }
+        fwrite(out, 1, bh.raw_size, fout);
+        written += bh.raw_size;
+    }
+    if (st) st->bytes_out = written;
+    free(payload);
+    free(out);
+    return check_huf2_end(ch, ok, written);
+}
+
+// magic 直接用 read 讀：stdio 不會先多讀一段放在自己的緩衝區，
+// 動態模式後面接著用 read 拿資料才不會漏掉；其他格式照常用 fread 接著讀
+static int read_magic(FILE* fin, unsigned char hdr[4]) {
+    size_t got = 0;
+    while (got < 4) {
+#ifdef _WIN32
+        long r = (long)_read(_fileno(fin), hdr + got, (unsigned)(4 - got));
+#else
+        long r = (long)read(fileno(fin), hdr + got, 4 - got);
+#endif
+        if (r <= 0) return -1;
+        got += (size_t)r;
+    }
+    return 0;
+}
+
+// 成功回傳 0；格式不對、資料壞掉或被截斷回傳 -1 (錯誤訊息已經印出)
+// own_output：fout 是 main 自己開的輸出檔 (不是 stdout 或別人給的 descriptor)，才能照位置寫入
+int decompress_file_bin(FILE* fin, FILE* fout, int own_output, int threads, HuffStats* stats) {
+    // 讀 magic 判斷格式
+    unsigned char hdr[4];
+    if (read_magic(fin, hdr) != 0) {
+        fprintf(stderr, "decode header error\n");
+        return -1;
+    }
+    if (memcmp(hdr, "HUF1", 4) == 0) {
+        if (stats) stats->format = "HUF1";
+        return decompress_huf1(fin, fout, stats);
+    }
+    if (memcmp(hdr, HUFA_MAGIC, 4) == 0) {
+        // 動態 Huffman：邊解邊更新樹，直到結束符號
+        int ok;
+        uint64_t written = adaptive_decompress(fin, fout, &ok);
+        if (stats) {
+            stats->format = HUFA_MAGIC;
+            stats->bytes_out = written;
+        }
+        if (!ok) fprintf(stderr, "ERROR: unexpected EOF after %llu bytes\n", (unsigned long long)written);
+        return ok ? 0 : -1;
+    }
+    ContainerHeader ch;
+    if (memcmp(hdr, HUF2_MAGIC, 4) != 0 || read_container_header(fin, &ch) != 0) {
+        fprintf(stderr, "decode header error\n");
+        return -1;
+    }
+    if (stats) stats->format = HUF2_MAGIC;
+    if (ch.version == HUF2_VERSION_V1) return decompress_huf2_v1(fin, fout, &ch, stats);
+
+    // 一般檔案就映射輸入；原始大小已知時輸出也先開好大小直接映射，block 直接解進去
+    MappedFile src, dst;
+    int in_mapped = map_input(fin, &src) == 0;
+    int out_mapped = 0;
+
+    // 有索引就把 block 分給多條 thread 解；沒有索引、讀不到或是 pipe 就照順序解
+    // 平行解是照 block 位置直接寫進輸出檔，stdout (可能是 >> 附加或 pipe) 只能照順序寫
+    if (threads > 1 && (ch.flags & HUF2_FLAG_INDEX) && own_output && file_seek(fin, 0, SEEK_CUR) == 0) {
+        BlockIndex idx;
+        if (index_read(fin, &ch, &idx) == 0) {
+            // 索引裡有總長度，連串流壓的檔也能先開好輸出
+            out_mapped = map_output(fout, idx.raw_pos, &dst) == 0;
+            int rc = decompress_blocks_parallel(fin, fout, &ch, &idx, threads,
+                                                in_mapped ? &src : NULL, out_mapped ? &dst : NULL, stats);
+            if (stats && rc == PAR_OK) stats->bytes_out = idx.raw_pos;
+            if (out_mapped) unmap_file(&dst, fout, rc == PAR_OK ? idx.raw_pos : 0);
+            if (in_mapped) unmap_file(&src, NULL, 0);
+            index_free(&idx);
+            if (rc == PAR_ERR_DATA) fprintf(stderr, "ERROR: corrupt block\n");
+            else if (rc != PAR_OK) fprintf(stderr, "ERROR: parallel decode failed\n");
+            return rc == PAR_OK ? 0 : -1;
+        }
+        if (file_seek(fin, ch.header_size, SEEK_SET) != 0) {
+            fprintf(stderr, "decode header error\n");
+            return -1;
+        }
+    }
+    if (own_output && ch.original_size != HUF2_SIZE_UNKNOWN) out_mapped = map_output(fout, ch.original_size, &dst) == 0;
+    int rc = decompress_huf2(fin, fout, &ch, in_mapped ? &src : NULL, out_mapped ? &dst : NULL, threads, stats);
+    if (in_mapped) unmap_file(&src, NULL, 0);
+    return rc;
+}
+
+
+
+// "-" 代表 stdin / stdout (切成 binary 模式)，其他就開檔
+static FILE* open_stream(const char* name, const char* mode) {
+    if (strcmp(name, "-") != 0) return fopen(name, mode);
+    FILE* fp = (mode[0] == 'r') ? stdin : stdout;
+#ifdef _WIN32
+    _setmode(_fileno(fp), _O_BINARY);
+#endif
+    return fp;
+}
+
+// ===== 字典模式 (-T 訓練、-D 使用)：很小的訊息共用一張事先算好的碼表 =====
+
+// 整個輸入讀進記憶體 (字典模式的訊息都很小)；失敗回傳 NULL
+static unsigned char* read_whole(FILE* fp, size_t* n) {
+    size_t cap = HUFF_IO_BUF, len = 0;
+    unsigned char* buf = (unsigned char*)malloc(cap);
+    while (buf) {
+        len += fread(buf + len, 1, cap - len, fp);
+        if (len < cap) break;
+        unsigned char* p = (unsigned char*)realloc(buf, cap * 2);
+        if (!p) {
+            free(buf);
+            return NULL;
+        }
+        buf = p;
+        cap *= 2;
+    }
+    *n = len;
+    return buf;
+}
+
+// 讀字典檔並建好碼表；失敗回傳 -1
+static int load_dict_file(const char* path, HuffDict* d) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return -1;
+    unsigned char buf[DICT_FILE_MAX];
+    size_t n = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    return dict_load(buf, n, d);
+}
+
+// 統計所有樣本檔的頻率，建字典寫到 fout；樣本是 "-" 時讀 stdin
+static int train_dict(char* const files[], int count, int limit_L, FILE* fout) {
+    uint64_t freq[MAX_SYMBOLS] = {0};
+    unsigned char* buf = (unsigned char*)malloc(HUFF_IO_BUF);
+    if (!buf) return -1;
+    for (int i = 0; i < count; i++) {
+        FILE* fp = open_stream(files[i], "rb");
+        if (!fp) {
+            perror(files[i]);
+            free(buf);
+            return -1;
+        }
+        size_t n;
+        while ((n = fread(buf, 1, HUFF_IO_BUF, fp)) > 0) {
+            int f[MAX_SYMBOLS] = {0};
+            count_block_frequency(buf, n, f);
+            for (int s = 0; s < MAX_SYMBOLS; s++) freq[s] += (uint64_t)f[s];
+        }
+        if (fp != stdin) fclose(fp);
+    }
+    free(buf);
+
+    HuffDict d;
+    if (dict_train(freq, limit_L, &d) != 0) return -1;
+    unsigned char out[DICT_FILE_MAX];
+    size_t m = dict_save(&d, out);
+    fprintf(stderr, "dictionary id=%08x (%zu bytes)\n", d.id, m);
+    dict_free(&d);
+    return fwrite(out, 1, m, fout) == m ? 0 : -1;
+}
+
+// 用字典壓一則訊息：不統計、不寫表
+static int compress_with_dict(FILE* fin, FILE* fout, const HuffDict* d, HuffStats* st) {
+    size_t n;
+    double t = st ? stats_now() : 0.0;
+    unsigned char* in = read_whole(fin, &n);
+    unsigned char* out = in ? (unsigned char*)malloc(dict_bound(d, n)) : NULL;
+    if (!out) {
+        free(in);
+        return -1;
+    }
+    if (st) t = stats_lap(st, STAT_READ, t);
+    size_t m = dict_compress(d, in, n, out);
+    if (st) t = stats_lap(st, STAT_ENCODE, t);
+    int rc = fwrite(out, 1, m, fout) == m ? 0 : -1;
+    if (st) {
+        stats_lap(st, STAT_WRITE, t);
+        st->format = DICT_MAGIC;
+        st->bytes_in = n;
+        st->bytes_out = m;
+        st->blocks = 1;
+    }
+    free(in);
+    free(out);
+    return rc;
+}
+
+static int decompress_with_dict(FILE* fin, FILE* fout, const HuffDict* d, HuffStats* st) {
+    size_t len, n;
+    uint64_t size;
+    double t = st ? stats_now() : 0.0;
+    unsigned char* in = read_whole(fin, &len);
+    if (!in || dict_get_size(d, in, len, &size) != 0 || size > SIZE_MAX) {
+        free(in);
+        return -1;
+    }
+    unsigned char* out = (unsigned char*)malloc(size ? (size_t)size : 1);
+    if (st) t = stats_lap(st, STAT_READ, t);
+    int rc = out ? dict_decompress(d, in, len, out, (size_t)size, &n) : -1;
+    if (st) t = stats_lap(st, STAT_DECODE, t);
+    if (rc == 0 && fwrite(out, 1, n, fout) != n) rc = -1;
+    if (st) {
+        stats_lap(st, STAT_WRITE, t);
+        st->format = DICT_MAGIC;
+        st->bytes_in = len;
+        st->bytes_out = rc == 0 ? n : 0;
+        st->blocks = 1;
+    }
+    free(in);
+    free(out);
+    return rc;
+}
 
 int main(int argc, char *argv[]) {
     int opt;
@@ -472,9 +794,27 @@ int main(int argc, char *argv[]) {
     char *inputFile = NULL;
     char *outputFile = NULL;
     int limit_length = -1;  // -1 表示沒限制
+    int show_tree = 0;      // -v 顯示 Huffman tree
+    uint32_t block_size = DEFAULT_BLOCK_SIZE; // -b 以 KiB 為單位
+    int threads = 1;        // -t 壓縮 / 解壓縮用幾條 thread
+    int streams = 1;        // -s 每個 block 用幾條 bitstream (1 或 4)
+    int adaptive = 0;       // -a 一次掃描的動態 Huffman
+    int order = 0;          // -k 1 用前一個 byte 當 context (order-1)
+    int rle = 0;            // -r 先試 run-length 前處理
+    int lz_level = 0;       // -z 1..9 先做 LZ77 (越大找越久)
+    int lz_window = 0;      // -w LZ77 window 的 bit 數 (0 = 預設)
+    int backend = BACKEND_HUFFMAN;  // -e huff|ans order-0 用哪種熵編碼
+    int sample = 0;         // -f N 只數 1/N 的 byte 建碼表 (快，但碼表沒那麼準)
+    int want_stats = 0;     // --stats[=檔名] 輸出各階段時間 (JSON)
+    const char* stats_file = NULL;  // NULL = 印到 stderr
+    const char* dict_file = NULL;   // -D 用預先訓練的字典壓 / 解
     int frequency_array[256] = {0};
+    static const struct option long_opts[] = {
+        { "stats", optional_argument, NULL, 'S' },
+        { NULL, 0, NULL, 0 }
+    };
 
-    while ((opt = getopt(argc, argv, "cdi:o:l:")) != -1) {
+    while ((opt = getopt_long(argc, argv, "cdTi:o:l:vb:t:s:ak:rz:w:e:f:D:", long_opts, NULL)) != -1) {
         switch(opt) {
             case 'c':
                 if (mode == MODE_NONE) mode = MODE_C;
@@ -484,6 +824,13 @@ int main(int argc, char *argv[]) {
                 if (mode == MODE_NONE) mode = MODE_D;
                 else fprintf(stderr, "Error: mode already specified\n");
                 break;
+            case 'T':
+                if (mode == MODE_NONE) mode = MODE_T;
+                else fprintf(stderr, "Error: mode already specified\n");
+                break;
+            case 'D':
+                dict_file = optarg;
+                break;
             case 'i':
                 inputFile = optarg;
                 break;
@@ -493,6 +840,76 @@ int main(int argc, char *argv[]) {
             case 'l':
                 limit_length = atoi(optarg);
                 break;
+            case 'v':
+                show_tree = 1;
+                break;
+            case 'b':
+                block_size = (uint32_t)atoi(optarg) << 10;
+                if (block_size < MIN_BLOCK_SIZE || block_size > MAX_BLOCK_SIZE) {
+                    fprintf(stderr, "Error: block size must be %u..%u KiB\n", MIN_BLOCK_SIZE >> 10, MAX_BLOCK_SIZE >> 10);
+                    return 1;
+                }
+                break;
+            case 't':
+                threads = atoi(optarg);
+                if (threads < 1 || threads > MAX_THREADS) {
+                    fprintf(stderr, "Error: thread count must be 1..%d\n", MAX_THREADS);
+                    return 1;
+                }
+                break;
+            case 'a':
+                adaptive = 1;
+                break;
+            case 'k':
+                order = atoi(optarg);
+                if (order != 0 && order != 1) {
+                    fprintf(stderr, "Error: context order must be 0 or 1\n");
+                    return 1;
+                }
+                break;
+            case 'r':
+                rle = 1;
+                break;
+            case 'z':
+                lz_level = atoi(optarg);
+                if (lz_level < 0 || lz_level > LZ_MAX_LEVEL) {
+                    fprintf(stderr, "Error: LZ77 level must be 0..%d\n", LZ_MAX_LEVEL);
+                    return 1;
+                }
+                break;
+            case 'w':
+                lz_window = atoi(optarg);
+                if (lz_window < LZ_MIN_WINDOW || lz_window > LZ_MAX_WINDOW) {
+                    fprintf(stderr, "Error: LZ77 window must be %d..%d bits\n", LZ_MIN_WINDOW, LZ_MAX_WINDOW);
+                    return 1;
+                }
+                break;
+            case 'e':
+                if (strcmp(optarg, "huff") == 0) backend = BACKEND_HUFFMAN;
+                else if (strcmp(optarg, "ans") == 0) backend = BACKEND_ANS;
+                else {
+                    fprintf(stderr, "Error: entropy coder must be huff or ans\n");
+                    return 1;
+                }
+                break;
+            case 'f':
+                sample = atoi(optarg);
+                if (sample < 2 || sample > SAMPLE_MAX_STRIDE) {
+                    fprintf(stderr, "Error: sample stride must be 2..%d\n", SAMPLE_MAX_STRIDE);
+                    return 1;
+                }
+                break;
+            case 'S':
+                want_stats = 1;
+                stats_file = optarg;
+                break;
+            case 's':
+                streams = atoi(optarg);
+                if (streams != 1 && streams != 4) {
+                    fprintf(stderr, "Error: stream count must be 1 or 4\n");
+                    return 1;
+                }
+                break;
             default:
                 fprintf(stderr, "Unknown option\n");
                 return 1;
@@ -500,59 +917,138 @@ int main(int argc, char *argv[]) {
     }
 
     if (mode == MODE_NONE) {
-        fprintf(stderr, "Error: -c or -d must be specified\n");
+        fprintf(stderr, "Error: -c, -d or -T must be specified\n");
         return 1;
     }
-    if (inputFile == NULL) {
-        fprintf(stderr, "Error: -i <input file> is required\n");
+    // 沒給 -i / -o 就用 stdin / stdout，可以接在 pipe 中間
+    if (inputFile == NULL) inputFile = "-";
+    if (outputFile == NULL) outputFile = "-";
+    int to_stdout = strcmp(outputFile, "-") == 0;
+    if (to_stdout && show_tree) {
+        fprintf(stderr, "Error: -v needs -o <output file>\n");
         return 1;
     }
-    if (outputFile == NULL) {
-        fprintf(stderr, "Error: -o <output file> is required\n");
-        return 1;
-    }
-     printf("mode=%d, input=%s, output=%s, limit=%d\n", mode, inputFile, outputFile, limit_length);
+    fprintf(to_stdout ? stderr : stdout, "mode=%d, input=%s, output=%s, limit=%d\n", mode, inputFile, outputFile, limit_length);
+    HuffStats stats;
+    stats_init(&stats);
+    HuffStats* st = want_stats ? &stats : NULL;
+    double start = stats_now();
+    FILE* fin = NULL;
+    FILE* fout = NULL;
     // TODO: 根據 mode 做 Huffman 壓縮或解壓縮
     
    
 
     
 
+    // -D：字典只載入一次，碼和解碼表都在裡面
+    HuffDict dict;
+    if (dict_file && load_dict_file(dict_file, &dict) != 0) {
+        fprintf(stderr, "Error: cannot load dictionary %s\n", dict_file);
+        return 1;
+    }
+
+    if (mode == MODE_T) {
+        // 樣本 = -i 加上後面其他沒有選項的參數
+        int count = 0;
+        char** samples = (char**)malloc(sizeof(char*) * (size_t)(argc - optind + 1));
+        if (!samples) return 1;
+        samples[count++] = inputFile;
+        for (int i = optind; i < argc; i++) samples[count++] = argv[i];
+        fout = open_stream(outputFile, "wb");
+        if (fout == NULL) {
+            perror("Error opening output file");
+            free(samples);
+            return 1;
+        }
+        int rc = train_dict(samples, count, limit_length, fout);
+        free(samples);
+        if (rc != 0) {
+            fprintf(stderr, "Error: dictionary training failed\n");
+            return 1;
+        }
+        fflush(fout);
+        return 0;
+    }
+
     if(mode == MODE_C){
          // 確定輸入檔案存在
-        FILE *fin = fopen(inputFile, "rb");
+        fin = open_stream(inputFile, "rb");
         if (fin == NULL) {
             perror("Error opening input file");
             return 1;
         }
 
         // 確定輸出檔案存在
-        FILE* fout = fopen(outputFile, "wb");
+        fout = open_stream(outputFile, "wb");
         if (fout == NULL) {
             perror("Error opening output file");
             fclose(fin);
             return 1;
         }
-        compress(fin, fout, limit_length);
+        output_fp = fout;
+        if (!to_stdout) output_path = outputFile;
+        if (dict_file) {
+            if (compress_with_dict(fin, fout, &dict, st) != 0) {
+                fprintf(stderr, "Error: dictionary compression failed\n");
+                compress_abort();
+            }
+        }
+        else if (adaptive) {
+            // 不統計、不寫表，讀到一個 byte 就編一個
+            if (adaptive_compress(fin, fout) != 0) {
+                fprintf(stderr, "Error: adaptive compression failed\n");
+                compress_abort();
+            }
+            stats.format = HUFA_MAGIC;
+        }
+        else {
+            BlockOptions opt = { limit_length, streams, order, rle, lz_level, lz_window, backend, sample, st };
+            compress(fin, fout, &opt, block_size, threads, show_tree);
+        }
+        fflush(fout);
     }
 
     else if(mode == MODE_D){
         // 確定輸出檔案存在
-        FILE* fin = fopen(inputFile, "rb");
+        fin = open_stream(inputFile, "rb");
         if (fin == NULL) {
             perror("Error opening output file");
             fclose(fin);
             return 1;
         }
-        // 確定輸出檔案存在
-        FILE* fout = fopen(outputFile, "wb");
+        // 確定輸出檔案存在 (要可讀寫才能映射)
+        fout = open_stream(outputFile, "w+b");
         if (fout == NULL) {
             perror("Error opening output file");
             fclose(fout);
             return 1;
         }
-        decompress_file_bin(fin, fout);
+        if (dict_file) {
+            if (decompress_with_dict(fin, fout, &dict, st) != 0) {
+                fprintf(stderr, "ERROR: message does not match dictionary or is corrupt\n");
+                return 1;
+            }
+        }
+        else if (decompress_file_bin(fin, fout, !to_stdout, threads, st) != 0) {
+            fflush(fout);
+            return 1;
+        }
+        fflush(fout);
     }
 
+    if (st) {
+        double total = stats_now() - start;
+        // 沒有在過程中算到的 byte 數就問檔案系統 (pipe 拿不到就是 null)
+        if (stats.bytes_in == STATS_UNKNOWN) stats.bytes_in = input_size(fin);
+        if (stats.bytes_out == STATS_UNKNOWN) stats.bytes_out = input_size(fout);
+        FILE* sf = stats_file ? fopen(stats_file, "w") : stderr;
+        if (!sf) {
+            perror("Error opening stats file");
+            return 1;
+        }
+        stats_write_json(sf, &stats, mode == MODE_C ? "compress" : "decompress", threads, total);
+        if (sf != stderr) fclose(sf);
+    }
     return 0;
 }
@@ -0,0 +1,91 @@
+#!/bin/sh
+# tests/roundtrip.sh - main 的壓縮 / 解壓縮回歸測試 (make test 會先編好再跑)
+# 用法：sh tests/roundtrip.sh [執行檔目錄，預設 build]
+#   語料用 huff_bench -g 產生 (固定種子)，每種選項都把每個檔壓完再解回來比對
+#   另外檢查第 1 版 HUF2 的舊檔 (tests/data) 還解得開，以及壞掉的輸入要失敗
+BIN=${1:-build}
+DATA=$(dirname "$0")/data
+TMP=${TMPDIR:-/tmp}/huff_test.$$
+fail=0
+
+mkdir -p "$TMP" || exit 1
+trap 'rm -rf "$TMP"' EXIT INT TERM
+
+bad() {
+    echo "FAIL: $*"
+    fail=1
+}
+
+# rt 壓縮選項...：語料裡每個檔都壓完再用 main -d 解回來比對
+rt() {
+    for f in "$TMP"/corpus/*; do
+        name=$(basename "$f")
+        if ! "$BIN/main" -c -i "$f" -o "$TMP/c.huf" "$@" >/dev/null 2>&1; then
+            bad "main -c $* ($name)"
+        elif ! "$BIN/main" -d -i "$TMP/c.huf" -o "$TMP/d.out" >/dev/null 2>&1 || ! cmp -s "$f" "$TMP/d.out"; then
+            bad "main -d after -c $* ($name)"
+        fi
+    done
+}
+
+"$BIN/huff_bench" -g -d "$TMP/corpus" || exit 1
+
+# --- 各種壓縮選項 ---
+rt
+rt -s 4
+rt -b 128 -t 4
+rt -a
+rt -l 12
+# deep.bin 的碼長會到 19 以上：一次補進 acc 的 bit 只保證 56 個，連續查表的次數要照這個算
+rt -l 19
+rt -l 19 -s 4
+rt -k 1
+rt -r
+rt -z 6
+rt -e ans
+rt -e ans -s 4
+rt -f 8
+
+# --- 平行解壓、stdout、pipe ---
+f=$TMP/corpus/text.txt
+"$BIN/main" -c -b 128 -i "$f" -o "$TMP/c.huf" >/dev/null 2>&1 || bad "main -c -b 128"
+"$BIN/main" -d -t 4 -i "$TMP/c.huf" -o "$TMP/d.out" >/dev/null 2>&1 && cmp -s "$f" "$TMP/d.out" || bad "main -d -t 4"
+# stdout 可能是 >> 附加，原本的內容要留著
+echo keep > "$TMP/d.out"
+"$BIN/main" -d -t 4 -i "$TMP/c.huf" -o - >> "$TMP/d.out" 2>/dev/null || bad "main -d -t 4 -o - exit code"
+(echo keep; cat "$f") | cmp -s - "$TMP/d.out" || bad "main -d -t 4 -o - >> file"
+"$BIN/main" -c -i - -o - < "$f" 2>/dev/null | "$BIN/main" -d -i - -o - 2>/dev/null | cmp -s "$f" - || bad "pipe"
+
+# --- 第 1 版 HUF2 (舊版 main 壓的檔) ---
+for v in v1_sample v1_sample_s4; do
+    "$BIN/main" -d -i "$DATA/$v.huf" -o "$TMP/d.out" >/dev/null 2>&1 && cmp -s "$DATA/v1_sample.txt" "$TMP/d.out" ||
+        bad "decode $v.huf"
+done
+
+# --- 字典模式 ---
+"$BIN/main" -T -i "$TMP/corpus/tiny500.txt" -o "$TMP/t.dict" "$TMP/corpus/tiny64.txt" >/dev/null 2>&1 || bad "main -T"
+for f in "$TMP"/corpus/tiny*.txt; do
+    name=$(basename "$f")
+    "$BIN/main" -c -D "$TMP/t.dict" -i "$f" -o "$TMP/c.huf" >/dev/null 2>&1 &&
+        "$BIN/main" -d -D "$TMP/t.dict" -i "$TMP/c.huf" -o "$TMP/d.out" >/dev/null 2>&1 && cmp -s "$f" "$TMP/d.out" ||
+        bad "main -D ($name)"
+done
+
+# --- 壓不下來的資料存原樣 block，不能比原檔大超過 1% ---
+f=$TMP/corpus/random.bin
+"$BIN/main" -c -i "$f" -o "$TMP/c.huf" >/dev/null 2>&1 || bad "main -c random.bin"
+size=$(wc -c < "$f")
+[ "$(wc -c < "$TMP/c.huf")" -le $((size + size / 100)) ] || bad "random.bin grew more than 1%"
+
+# --- 壞掉的輸入要回傳非 0 ---
+head -c 100000 "$TMP/c.huf" > "$TMP/cut.huf"
+"$BIN/main" -d -i "$TMP/cut.huf" -o "$TMP/d.out" >/dev/null 2>&1 && bad "truncated input accepted"
+"$BIN/main" -d -t 4 -i "$TMP/cut.huf" -o "$TMP/d.out" >/dev/null 2>&1 && bad "truncated input accepted (-t 4)"
+"$BIN/main" -d -i "$TMP/corpus/text.txt" -o "$TMP/d.out" >/dev/null 2>&1 && bad "non-HUF input accepted"
+# 碼長限制放不下所有符號：失敗而且不留下輸出檔
+rm -f "$TMP/c.huf"
+"$BIN/main" -c -l 3 -i "$TMP/corpus/random.bin" -o "$TMP/c.huf" >/dev/null 2>&1 && bad "-l 3 accepted"
+[ -e "$TMP/c.huf" ] && bad "-l 3 left an output file"
+
+[ $fail -eq 0 ] && echo "all round trips passed"
+exit $fail